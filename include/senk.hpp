@@ -14,6 +14,7 @@
 
 #include "senk_io.hpp"
 #include "senk_matrix.hpp"
+#include "senk_factor.hpp"
 #include "senk_utils.hpp"
 #include "senk_graph.hpp"
 //#include "senk_blas1.hpp"
@@ -22,6 +23,11 @@
 #include "senk_bicgstab.hpp"
 #include "senk_gmres.hpp"
 #include "senk_gcr.hpp"
+#include "senk_idrs.hpp"
+#include "senk_cheby.hpp"
+#include "senk_amg.hpp"
+#include "senk_sai.hpp"
+#include "senk_schwarz.hpp"
 
 /**
  * @namespace senk
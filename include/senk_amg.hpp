@@ -0,0 +1,524 @@
+/**
+ * @file senk_amg.hpp
+ * @brief The smoothed aggregation algebraic multigrid preconditioner is defined.
+ * @author Kengo Suzuki
+ * @date 5/8/2021
+ */
+#ifndef SENK_AMG_HPP
+#define SENK_AMG_HPP
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "senk_utils.hpp"
+#include "senk_matrix.hpp"
+#include "senk_graph.hpp"
+#include "senk_sparse.hpp"
+#include "senk_blas1.hpp"
+#include "senk_blas2.hpp"
+#include "senk_cheby.hpp"
+#include "senk_helper.hpp"
+
+namespace senk {
+/**
+ * @brief The algebraic multigrid preconditioner is located in namespace amg.
+ */
+namespace amg {
+/**
+ * @brief Group the nodes of a matrix into aggregates of strongly connected nodes.
+ * @details j is a strong neighbor of i if |a_ij| >= theta * sqrt(|a_ii * a_jj|).
+ * In the first phase, a node whose strong neighbors are all free forms an
+ * aggregate with them. In the second phase, the remaining nodes join the
+ * aggregate of their strongest aggregated neighbor. In the last phase, the
+ * nodes still left form new aggregates with their free strong neighbors, so
+ * that every node, including isolated ones, belongs to an aggregate.
+ * @tparam T The type of the matrix.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param agg A pointer to receive the aggregate of each node.
+ * @param num_agg A variable to receive the number of aggregates.
+ * @param N The size of the matrix.
+ * @param theta The strength threshold.
+ */
+template <typename T>
+void Aggregate(
+    T *val, int *cind, int *rptr,
+    int **agg, int *num_agg, int N, T theta)
+{
+    T *diag;
+    matrix::GetDiag<T>(val, cind, rptr, &diag, N);
+    bool *strong = utils::SafeMalloc<bool>(rptr[N]);
+    #pragma omp parallel for
+    for(int i=0; i<N; i++) {
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            strong[j] = cind[j] != i &&
+                std::abs(val[j]) >= theta * std::sqrt(std::abs(diag[i] * diag[cind[j]]));
+        }
+    }
+    *agg = utils::SafeMalloc<int>(N);
+    for(int i=0; i<N; i++) { (*agg)[i] = -1; }
+    int cnt = 0;
+    // Phase 1
+    for(int i=0; i<N; i++) {
+        if((*agg)[i] != -1) continue;
+        bool has = false, avail = true;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            if(!strong[j]) continue;
+            has = true;
+            if((*agg)[cind[j]] != -1) { avail = false; break; }
+        }
+        if(!has || !avail) continue;
+        (*agg)[i] = cnt;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            if(strong[j]) (*agg)[cind[j]] = cnt;
+        }
+        cnt++;
+    }
+    // Phase 2
+    int *agg1 = utils::SafeMalloc<int>(N);
+    utils::Copy<int>(*agg, agg1, N);
+    for(int i=0; i<N; i++) {
+        if(agg1[i] != -1) continue;
+        T max = 0;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            if(!strong[j] || agg1[cind[j]] == -1) continue;
+            if(std::abs(val[j]) > max) {
+                max = std::abs(val[j]);
+                (*agg)[i] = agg1[cind[j]];
+            }
+        }
+    }
+    // Phase 3
+    for(int i=0; i<N; i++) {
+        if((*agg)[i] != -1) continue;
+        (*agg)[i] = cnt;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            if(strong[j] && (*agg)[cind[j]] == -1) (*agg)[cind[j]] = cnt;
+        }
+        cnt++;
+    }
+    *num_agg = cnt;
+    free(diag);
+    free(strong);
+    free(agg1);
+}
+/**
+ * @brief The hierarchy of the smoothed aggregation algebraic multigrid method.
+ * @details The constructor builds the hierarchy and Apply performs a V-cycle.
+ * The prolongation of each level is the tentative one, which has one nonzero
+ * per row for the aggregate of the row, smoothed by a damped Jacobi step,
+ * P = (I - omega D^-1 A) P0 with omega = 4/3 / rho(D^-1 A). The restriction
+ * is R = P^T and the coarse matrix is the Galerkin product R A P. The
+ * coarsest matrix is factorized densely if its size is not larger than
+ * coarse_size; otherwise (the aggregation stalled or max_level was reached)
+ * it is smoothed like the other levels. The matrix of the finest level is
+ * not copied, so it must stay alive while the hierarchy is used.
+ * @tparam T The type of the matrix and vectors.
+ */
+template <typename T>
+class Hierarchy {
+private:
+    //! The number of levels.
+    int num_level;
+    //! The size of the matrix of each level.
+    int *N;
+    //! val arrays of the matrix of each level.
+    T **val;
+    //! cind arrays of the matrix of each level.
+    int **cind;
+    //! rptr arrays of the matrix of each level.
+    int **rptr;
+    //! val arrays of the prolongation from level l+1 to level l.
+    T **pval;
+    //! cind arrays of the prolongation from level l+1 to level l.
+    int **pcind;
+    //! rptr arrays of the prolongation from level l+1 to level l.
+    int **prptr;
+    //! val arrays of the restriction from level l to level l+1.
+    T **rval;
+    //! cind arrays of the restriction from level l to level l+1.
+    int **rcind;
+    //! rptr arrays of the restriction from level l to level l+1.
+    int **rrptr;
+    //! The inverted diagonal of each level (Gauss-Seidel).
+    T **dinv;
+    //! The number of colors of each level (Gauss-Seidel).
+    int *num_color;
+    //! The offsets of the colors in order (Gauss-Seidel).
+    int **size_color;
+    //! The nodes of each level grouped by color (Gauss-Seidel).
+    int **order;
+    //! The upper bound of the spectrum of each level (Chebyshev).
+    T *lmax;
+    //! The right-hand side of each level.
+    T **b;
+    //! The solution of each level.
+    T **x;
+    //! The residual of each level.
+    T **r;
+    //! Work arrays of size 4 * N of each level (Chebyshev).
+    T **work;
+    //! The number of levels that are smoothed.
+    int num_smooth;
+    //! The LU factors of the coarsest matrix stored in column-major order.
+    T *lu;
+    //! The pivot rows of the coarsest matrix.
+    int *piv;
+    //! 0 for Gauss-Seidel and 1 for Chebyshev.
+    int smoother;
+    //! The number of sweeps (Gauss-Seidel) or steps (Chebyshev) of the smoother.
+    int nu;
+
+    void Smooth(int l, T *bl, T *xl, bool zero, bool forward) {
+        if(smoother == 0) {
+            if(zero) {
+                #pragma omp for simd
+                for(int i=0; i<N[l]; i++) { xl[i] = 0; }
+            }
+            for(int s=0; s<nu; s++) {
+                for(int c=0; c<num_color[l]; c++) {
+                    int col = forward ? c : num_color[l]-1-c;
+                    #pragma omp for
+                    for(int k=size_color[l][col]; k<size_color[l][col+1]; k++) {
+                        int i = order[l][k];
+                        T temp = bl[i];
+                        for(int j=rptr[l][i]; j<rptr[l][i+1]; j++) {
+                            temp -= val[l][j] * xl[cind[l][j]];
+                        }
+                        xl[i] += temp * dinv[l][i];
+                    }
+                }
+            }
+        }else {
+            if(zero) {
+                sparse::orphan::ChebyCsr<T>(val[l], cind[l], rptr[l], bl, xl, work[l], lmax[l]/10, lmax[l], nu, N[l]);
+            }else {
+                sparse::orphan::SpmvCsr<T>(val[l], cind[l], rptr[l], xl, r[l], N[l]);
+                blas1::orphan::Axpby<T>(1, bl, -1, r[l], N[l]);
+                sparse::orphan::ChebyCsr<T>(val[l], cind[l], rptr[l], r[l], &work[l][3*N[l]], work[l], lmax[l]/10, lmax[l], nu, N[l]);
+                blas1::orphan::Axpy<T>(1, &work[l][3*N[l]], xl, N[l]);
+            }
+        }
+    }
+public:
+    /**
+     * @brief Constructor.
+     * @details Build the hierarchy until the size of the matrix is not
+     * larger than coarse_size, the aggregation does not reduce the size or
+     * max_level levels are made.
+     * @param a_val val array of the CSR storage format.
+     * @param a_cind column index array of the CSR storage format.
+     * @param a_rptr row pointer array of the CSR storage format.
+     * @param a_N The size of the matrix.
+     * @param smoother_type "GS" for the multicolor Gauss-Seidel smoother or "Chebyshev".
+     * @param a_nu The number of sweeps (GS) or steps (Chebyshev) of the smoother.
+     * @param max_level The maximum number of levels.
+     * @param coarse_size The maximum size of the coarsest matrix that is factorized densely.
+     * @param theta The strength threshold of the aggregation, e.g. 0.08.
+     */
+    Hierarchy(
+        T *a_val, int *a_cind, int *a_rptr, int a_N,
+        const char *smoother_type, int a_nu,
+        int max_level, int coarse_size, T theta)
+    {
+        if(std::strcmp(smoother_type, "GS") == 0) {
+            smoother = 0;
+        }else if(std::strcmp(smoother_type, "Chebyshev") == 0) {
+            smoother = 1;
+        }else {
+            printf("Error: Hierarchy, invalid smoother\n");
+            exit(1);
+        }
+        nu = a_nu;
+        N     = utils::SafeMalloc<int>(max_level);
+        val   = utils::SafeCalloc<T*>(max_level);
+        cind  = utils::SafeCalloc<int*>(max_level);
+        rptr  = utils::SafeCalloc<int*>(max_level);
+        pval  = utils::SafeCalloc<T*>(max_level);
+        pcind = utils::SafeCalloc<int*>(max_level);
+        prptr = utils::SafeCalloc<int*>(max_level);
+        rval  = utils::SafeCalloc<T*>(max_level);
+        rcind = utils::SafeCalloc<int*>(max_level);
+        rrptr = utils::SafeCalloc<int*>(max_level);
+        dinv  = utils::SafeCalloc<T*>(max_level);
+        num_color  = utils::SafeCalloc<int>(max_level);
+        size_color = utils::SafeCalloc<int*>(max_level);
+        order = utils::SafeCalloc<int*>(max_level);
+        lmax  = utils::SafeCalloc<T>(max_level);
+        b     = utils::SafeCalloc<T*>(max_level+1);
+        x     = utils::SafeCalloc<T*>(max_level);
+        r     = utils::SafeCalloc<T*>(max_level);
+        work  = utils::SafeCalloc<T*>(max_level);
+        N[0] = a_N;
+        val[0] = a_val; cind[0] = a_cind; rptr[0] = a_rptr;
+        int l;
+        for(l=0; l<max_level-1 && N[l]>coarse_size; l++) {
+            int n = N[l];
+            int *agg;
+            int nc;
+            Aggregate<T>(val[l], cind[l], rptr[l], &agg, &nc, n, theta);
+            if(nc == n) { free(agg); break; }
+            // S = I - omega D^-1 A
+            T *diag;
+            matrix::GetDiag<T>(val[l], cind[l], rptr[l], &diag, n);
+            T *sval = utils::SafeMalloc<T>(rptr[l][n]);
+            for(int i=0; i<n; i++) {
+                for(int j=rptr[l][i]; j<rptr[l][i+1]; j++) {
+                    sval[j] = val[l][j] / diag[i];
+                }
+            }
+            T lmin, rho;
+            solver::EstimateSpectrum<T>(sval, cind[l], rptr[l], &lmin, &rho, 10, n);
+            T omega = 4.0 / 3.0 / rho;
+            for(int i=0; i<n; i++) {
+                for(int j=rptr[l][i]; j<rptr[l][i+1]; j++) {
+                    sval[j] = (cind[l][j] == i) ? 1 - omega * sval[j] : -omega * sval[j];
+                }
+            }
+            // P0
+            T *tval = utils::SafeMalloc<T>(n);
+            int *tcind = utils::SafeMalloc<int>(n);
+            int *trptr = utils::SafeMalloc<int>(n+1);
+            for(int i=0; i<n; i++) {
+                tval[i] = 1; tcind[i] = agg[i]; trptr[i] = i;
+            }
+            trptr[n] = n;
+            matrix::SpGemm<T>(sval, cind[l], rptr[l], tval, tcind, trptr, &pval[l], &pcind[l], &prptr[l], n, nc);
+            matrix::Csr2Csc<T>(pval[l], pcind[l], prptr[l], &rval[l], &rcind[l], &rrptr[l], n, nc);
+            T *apval;
+            int *apcind, *aprptr;
+            matrix::SpGemm<T>(val[l], cind[l], rptr[l], pval[l], pcind[l], prptr[l], &apval, &apcind, &aprptr, n, nc);
+            matrix::SpGemm<T>(rval[l], rcind[l], rrptr[l], apval, apcind, aprptr, &val[l+1], &cind[l+1], &rptr[l+1], nc, nc);
+            N[l+1] = nc;
+            free(agg);
+            free(diag);
+            free(sval);
+            free(tval); free(tcind); free(trptr);
+            free(apval); free(apcind); free(aprptr);
+        }
+        num_level = l+1;
+        // The coarsest level is solved directly only if it is small enough
+        num_smooth = (N[num_level-1] > coarse_size) ? num_level : num_level-1;
+        for(l=0; l<num_smooth; l++) {
+            int n = N[l];
+            if(smoother == 0) {
+                T *diag;
+                matrix::GetDiag<T>(val[l], cind[l], rptr[l], &diag, n);
+                dinv[l] = utils::SafeMalloc<T>(n);
+                for(int i=0; i<n; i++) { dinv[l][i] = 1 / diag[i]; }
+                free(diag);
+                int *RP;
+                graph::GetAMCPermutation(cind[l], rptr[l], &num_color[l], &size_color[l], &order[l], &RP, n, false);
+                free(RP);
+            }else {
+                T lmin;
+                solver::EstimateSpectrum<T>(val[l], cind[l], rptr[l], &lmin, &lmax[l], 10, n);
+                work[l] = new T[4*n];
+            }
+            if(l > 0) x[l] = new T[n];
+            r[l] = new T[n];
+            if(l < num_level-1) b[l+1] = new T[N[l+1]];
+        }
+        int n = N[num_level-1];
+        if(num_level > 1 && num_smooth < num_level) x[num_level-1] = new T[n];
+        lu  = nullptr;
+        piv = nullptr;
+        if(num_smooth == num_level) return;
+        lu  = new T[n*n];
+        piv = new int[n];
+        for(int i=0; i<n*n; i++) { lu[i] = 0; }
+        for(int i=0; i<n; i++) {
+            for(int j=rptr[num_level-1][i]; j<rptr[num_level-1][i+1]; j++) {
+                lu[cind[num_level-1][j]*n+i] = val[num_level-1][j];
+            }
+        }
+        blas2::Getrf<T>(lu, piv, n);
+    }
+    /**
+     * @brief Destructor.
+     * @details Free all memories except for the matrix of the finest level.
+     */
+    ~Hierarchy() {
+        for(int l=0; l<num_level; l++) {
+            if(l > 0) { free(val[l]); free(cind[l]); free(rptr[l]); }
+            if(l < num_level-1) {
+                free(pval[l]); free(pcind[l]); free(prptr[l]);
+                free(rval[l]); free(rcind[l]); free(rrptr[l]);
+                delete[] b[l+1];
+            }
+            if(l < num_smooth) {
+                if(smoother == 0) { free(dinv[l]); free(size_color[l]); free(order[l]); }
+                delete[] work[l];
+                delete[] r[l];
+            }
+            delete[] x[l];
+        }
+        free(N);
+        free(val); free(cind); free(rptr);
+        free(pval); free(pcind); free(prptr);
+        free(rval); free(rcind); free(rrptr);
+        free(dinv); free(num_color); free(size_color); free(order);
+        free(lmax);
+        free(b); free(x); free(r); free(work);
+        delete[] lu;
+        delete[] piv;
+    }
+    /**
+     * @brief Apply a V-cycle, z = M^-1 rhs, started from zero.
+     * @details This function must be called by all threads of an enclosing
+     * parallel region. The coarsest system is solved by a single thread.
+     * @param rhs A 1D-array of the size of the finest level.
+     * @param z A 1D-array of the size of the finest level. It must not overlap rhs.
+     */
+    void Apply(T *rhs, T *z) {
+        int L = num_level-1;
+        for(int l=0; l<L; l++) {
+            T *bl = (l == 0) ? rhs : b[l];
+            T *xl = (l == 0) ? z : x[l];
+            Smooth(l, bl, xl, true, true);
+            sparse::orphan::SpmvCsr<T>(val[l], cind[l], rptr[l], xl, r[l], N[l]);
+            blas1::orphan::Axpby<T>(1, bl, -1, r[l], N[l]);
+            sparse::orphan::SpmvCsr<T>(rval[l], rcind[l], rrptr[l], r[l], b[l+1], N[l+1]);
+        }
+        T *xL = (L == 0) ? z : x[L];
+        if(num_smooth == num_level) {
+            Smooth(L, (L == 0) ? rhs : b[L], xL, true, true);
+            Smooth(L, (L == 0) ? rhs : b[L], xL, false, false);
+        }else {
+            #pragma omp single
+            blas2::Getrs<T>(lu, piv, (L == 0) ? rhs : b[L], xL, N[L]);
+        }
+        for(int l=L-1; l>=0; l--) {
+            T *bl = (l == 0) ? rhs : b[l];
+            T *xl = (l == 0) ? z : x[l];
+            sparse::orphan::SpmvCsr<T>(pval[l], pcind[l], prptr[l], x[l+1], r[l], N[l]);
+            blas1::orphan::Axpy<T>(1, r[l], xl, N[l]);
+            Smooth(l, bl, xl, false, false);
+        }
+    }
+    /**
+     * @brief Return the number of levels.
+     */
+    inline int GetNumLevel() { return num_level; }
+    /**
+     * @brief Return the size of the matrix of level l.
+     */
+    inline int GetSize(int l) { return N[l]; }
+    /**
+     * @brief Return the number of nonzero elements of the matrix of level l.
+     */
+    inline int GetNnz(int l) { return rptr[l][N[l]]; }
+};
+
+} // namespace amg
+
+namespace solver {
+/**
+ * @brief The AMG preconditioned GMRES(m) solver.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param amg The hierarchy built from the same matrix. Each application of the preconditioner is one V-cycle.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, typename TV = T>
+void AmgGmresm(
+    T *val, int *cind, int *rptr,
+    amg::Hierarchy<T> *amg,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                amg->Apply(w, t);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
+            }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            amg->Apply(W, t);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] red;
+}
+
+} // namespace solver
+
+} // namespace senk
+
+#endif
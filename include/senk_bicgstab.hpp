@@ -1,6 +1,6 @@
 /**
  * @file senk_bicgstab.hpp
- * @brief The BiCGStab method is defined.
+ * @brief The BiCGStab and BiCGStab(l) methods are defined.
  * @author Kengo Suzuki
  * @date 5/8/2021
  */
@@ -9,6 +9,8 @@
 
 #include "senk_sparse.hpp"
 #include "senk_blas1.hpp"
+#include "senk_blas2.hpp"
+#include "senk_utils.hpp"
 
 namespace senk {
 
@@ -32,50 +34,61 @@ void Bicgstab(
     T *b, T *x, T nrm_b,
     int max_iter, int N, T epsilon)
 {
-    int i;
-    int flag = 0;
     T *r    = new T[N];
     T *rstr = new T[N];
     T *p    = new T[N];
     T *Ap   = new T[N];
     T *s    = new T[N];
     T *As   = new T[N];
-    T *temp = new T[N];
-    T alpha, beta, omega;
-    T r_rstr, prev;
-    T nrm_r = nrm_b;
+    T *red  = new T[helper::MaxThreads()*2];
 
-    sparse::SpmvCsr<T>(val, cind, rptr, x, r, N);
-    blas1::Axpby<T>(1, b, -1, r, N);
-    blas1::Copy<T>(r, rstr, N);
-    blas1::Copy<T>(r, p, N);
-    r_rstr = blas1::Dot<T>(r, rstr, N);
-    for(i=0; i<max_iter; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, p, Ap, N);
-        alpha = r_rstr / blas1::Dot<T>(Ap, rstr, N);
-        blas1::Axpyz<T>(-alpha, Ap, r, s, N);
-        sparse::SpmvCsr<T>(val, cind, rptr, s, As, N);
-        omega = blas1::Dot<T>(As, s, N) / blas1::Dot<T>(As, As, N);
-        blas1::Axpy<T>(alpha, p, x, N);
-        blas1::Axpy<T>(omega, s, x, N);
-        blas1::Axpyz<T>(-omega, As, s, r, N);
-        nrm_r = blas1::Nrm2<T>(r, N);
-        printf("%d %e\n", i+1, nrm_r/nrm_b);
-        if(nrm_r < epsilon * nrm_b) {
-            printf("# iter %d\n", i+1);
-            printf("# res %e\n", nrm_r/nrm_b);
-            flag = 1;
-            break;
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T alpha, beta, omega;
+        T dots[2];
+        T r_rstr, prev;
+        T nrm_r = nrm_b;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        blas1::orphan::Copy<T>(r, rstr, N);
+        blas1::orphan::Copy<T>(r, p, N);
+        r_rstr = blas1::orphan::Dot<T>(r, rstr, red, N);
+        for(i=0; i<max_iter; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, p, Ap, N);
+            alpha = r_rstr / blas1::orphan::Dot<T>(Ap, rstr, red, N);
+            blas1::orphan::Axpyz<T>(-alpha, Ap, r, s, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, s, As, N);
+            blas1::orphan::DotPair<T>(As, s, As, dots, red, N);
+            omega = dots[0] / dots[1];
+            blas1::orphan::Axpbypcz<T>(alpha, p, omega, s, 1, x, N);
+            blas1::orphan::AxpyzDotPair<T>(-omega, As, s, r, rstr, dots, red, N);
+            nrm_r = std::sqrt(dots[0]);
+            #pragma omp master
+            printf("%d %e\n", i+1, nrm_r/nrm_b);
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("# iter %d\n", i+1);
+                    printf("# res %e\n", nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+            prev = r_rstr;
+            r_rstr = dots[1];
+            beta = alpha / omega * r_rstr / prev;
+            blas1::orphan::Axpbypcz<T>(1, r, -beta*omega, Ap, beta, p, N);
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
         }
-        prev = r_rstr;
-        r_rstr = blas1::Dot<T>(r, rstr, N);
-        beta = alpha / omega * r_rstr / prev;
-        blas1::Axpyz<T>(-omega, Ap, p, temp, N);
-        blas1::Axpyz<T>(beta, temp, r, p, N);
-    }
-    if(!flag) {
-        printf("# iter %d (max)\n", i);
-        printf("# res %e\n", nrm_r/nrm_b);
     }
     delete[] r;
     delete[] rstr;
@@ -83,7 +96,7 @@ void Bicgstab(
     delete[] Ap;
     delete[] s;
     delete[] As;
-    delete[] temp;
+    delete[] red;
 }
 /**
  * @brief ILU preconditioned BiCGStab solver
@@ -112,8 +125,6 @@ void IluBicgstab(
     T *b, T *x, T nrm_b,
     int max_iter, int N, T epsilon)
 {
-    int i;
-    int flag = 0;
     T *r    = new T[N];
     T *rstr = new T[N];
     T *p    = new T[N];
@@ -122,47 +133,59 @@ void IluBicgstab(
     T *s    = new T[N];
     T *Ks   = new T[N];
     T *AKs  = new T[N];
-    T *temp = new T[N];
+    T *red  = new T[helper::MaxThreads()*2];
 
-    T alpha, beta, omega;
-    T r_rstr, prev;
-    T nrm_r = nrm_b;
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T alpha, beta, omega;
+        T dots[2];
+        T r_rstr, prev;
+        T nrm_r = nrm_b;
 
-    sparse::SpmvCsr<T>(val, cind, rptr, x, r, N);
-    blas1::Axpby<T>(1, b, -1, r, N);
-    blas1::Copy<T>(r, rstr, N);
-    blas1::Copy<T>(r, p, N);
-    r_rstr = blas1::Dot<T>(r, rstr, N);
-    for(i=0; i<max_iter; i++) {
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, p, Kp, N);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, Kp, Kp, N);
-        sparse::SpmvCsr<T>(val, cind, rptr, Kp, AKp, N);
-        alpha = r_rstr / blas1::Dot<T>(AKp, rstr, N);
-        blas1::Axpyz(-alpha, AKp, r, s, N);
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, s, Ks, N);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, Ks, Ks, N);
-        sparse::SpmvCsr<T>(val, cind, rptr, Ks, AKs, N);
-        omega = blas1::Dot<T>(AKs, s, N) / blas1::Dot<T>(AKs, AKs, N);
-        blas1::Axpy<T>(alpha, Kp, x, N);
-        blas1::Axpy<T>(omega, Ks, x, N);
-        blas1::Axpyz<T>(-omega, AKs, s, r, N);
-        nrm_r = blas1::Nrm2<T>(r, N);
-        printf("%d %e\n", i+1, nrm_r/nrm_b);
-        if(nrm_r < epsilon * nrm_b) {
-            printf("# iter %d\n", i+1);
-            printf("# res %e\n", nrm_r/nrm_b);
-            flag = 1;
-            break;
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        blas1::orphan::Copy<T>(r, rstr, N);
+        blas1::orphan::Copy<T>(r, p, N);
+        r_rstr = blas1::orphan::Dot<T>(r, rstr, red, N);
+        for(i=0; i<max_iter; i++) {
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, p, Kp, N);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, Kp, Kp, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kp, AKp, N);
+            alpha = r_rstr / blas1::orphan::Dot<T>(AKp, rstr, red, N);
+            blas1::orphan::Axpyz<T>(-alpha, AKp, r, s, N);
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, s, Ks, N);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, Ks, Ks, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Ks, AKs, N);
+            blas1::orphan::DotPair<T>(AKs, s, AKs, dots, red, N);
+            omega = dots[0] / dots[1];
+            blas1::orphan::Axpbypcz<T>(alpha, Kp, omega, Ks, 1, x, N);
+            blas1::orphan::AxpyzDotPair<T>(-omega, AKs, s, r, rstr, dots, red, N);
+            nrm_r = std::sqrt(dots[0]);
+            #pragma omp master
+            printf("%d %e\n", i+1, nrm_r/nrm_b);
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("# iter %d\n", i+1);
+                    printf("# res %e\n", nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+            prev = r_rstr;
+            r_rstr = dots[1];
+            beta = alpha / omega * r_rstr / prev;
+            blas1::orphan::Axpbypcz<T>(1, r, -beta*omega, AKp, beta, p, N);
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
         }
-        prev = r_rstr;
-        r_rstr = blas1::Dot<T>(r, rstr, N);
-        beta = alpha / omega * r_rstr / prev;
-        blas1::Axpyz<T>(-omega, AKp, p, temp, N);
-        blas1::Axpyz<T>(beta, temp, r, p, N);
-    }
-    if(!flag) {
-        printf("# iter %d (max)\n", i);
-        printf("# res %e\n", nrm_r/nrm_b);
     }
     delete[] r;
     delete[] rstr;
@@ -172,7 +195,7 @@ void IluBicgstab(
     delete[] s;
     delete[] Ks;
     delete[] AKs;
-    delete[] temp;
+    delete[] red;
 }
 /**
  * @brief ILUB preconditioned BiCGStab solver
@@ -203,8 +226,6 @@ void IlubBicgstab(
     T *b, T *x, T nrm_b,
     int max_iter, int N, T epsilon)
 {
-    int i;
-    int flag = 0;
     T *r    = new T[N];
     T *rstr = new T[N];
     T *p    = new T[N];
@@ -213,47 +234,59 @@ void IlubBicgstab(
     T *s    = new T[N];
     T *Ks   = new T[N];
     T *AKs  = new T[N];
-    T *temp = new T[N];
+    T *red  = new T[helper::MaxThreads()*2];
 
-    T alpha, beta, omega;
-    T r_rstr, prev;
-    T nrm_r = nrm_b;
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T alpha, beta, omega;
+        T dots[2];
+        T r_rstr, prev;
+        T nrm_r = nrm_b;
 
-    sparse::SpmvCsr<T>(val, cind, rptr, x, r, N);
-    blas1::Axpby<T>(1, b, -1, r, N);
-    blas1::Copy<T>(r, rstr, N);
-    blas1::Copy<T>(r, p, N);
-    r_rstr = blas1::Dot<T>(r, rstr, N);
-    for(i=0; i<max_iter; i++) {
-        sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, p, Kp, N);
-        sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Kp, Kp, N);
-        sparse::SpmvCsr<T>(val, cind, rptr, Kp, AKp, N);
-        alpha = r_rstr / blas1::Dot(AKp, rstr, N);
-        blas1::Axpyz(-alpha, AKp, r, s, N);
-        sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, s, Ks, N);
-        sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Ks, Ks, N);
-        sparse::SpmvCsr<T>(val, cind, rptr, Ks, AKs, N);
-        omega = blas1::Dot<T>(AKs, s, N) / blas1::Dot<T>(AKs, AKs, N);
-        blas1::Axpy<T>(alpha, Kp, x, N);
-        blas1::Axpy<T>(omega, Ks, x, N);
-        blas1::Axpyz<T>(-omega, AKs, s, r, N);
-        nrm_r = blas1::Nrm2<T>(r, N);
-        printf("%d %e\n", i+1, nrm_r/nrm_b);
-        if(nrm_r < epsilon * nrm_b) {
-            printf("# iter %d\n", i+1);
-            printf("# res %e\n", nrm_r/nrm_b);
-            flag = 1;
-            break;
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        blas1::orphan::Copy<T>(r, rstr, N);
+        blas1::orphan::Copy<T>(r, p, N);
+        r_rstr = blas1::orphan::Dot<T>(r, rstr, red, N);
+        for(i=0; i<max_iter; i++) {
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, p, Kp, N);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Kp, Kp, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kp, AKp, N);
+            alpha = r_rstr / blas1::orphan::Dot<T>(AKp, rstr, red, N);
+            blas1::orphan::Axpyz<T>(-alpha, AKp, r, s, N);
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, s, Ks, N);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Ks, Ks, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Ks, AKs, N);
+            blas1::orphan::DotPair<T>(AKs, s, AKs, dots, red, N);
+            omega = dots[0] / dots[1];
+            blas1::orphan::Axpbypcz<T>(alpha, Kp, omega, Ks, 1, x, N);
+            blas1::orphan::AxpyzDotPair<T>(-omega, AKs, s, r, rstr, dots, red, N);
+            nrm_r = std::sqrt(dots[0]);
+            #pragma omp master
+            printf("%d %e\n", i+1, nrm_r/nrm_b);
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("# iter %d\n", i+1);
+                    printf("# res %e\n", nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+            prev = r_rstr;
+            r_rstr = dots[1];
+            beta = alpha / omega * r_rstr / prev;
+            blas1::orphan::Axpbypcz<T>(1, r, -beta*omega, AKp, beta, p, N);
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
         }
-        prev = r_rstr;
-        r_rstr = blas1::Dot<T>(r, rstr, N);
-        beta = alpha / omega * r_rstr / prev;
-        blas1::Axpyz<T>(-omega, AKp, p, temp, N);
-        blas1::Axpyz<T>(beta, temp, r, p, N);
-    }
-    if(!flag) {
-        printf("# iter %d (max)\n", i);
-        printf("# res %e\n", nrm_r/nrm_b);
     }
     delete[] r;
     delete[] rstr;
@@ -263,7 +296,518 @@ void IlubBicgstab(
     delete[] s;
     delete[] Ks;
     delete[] AKs;
-    delete[] temp;
+    delete[] red;
+}
+
+/**
+ * @brief Non-preconditioned BiCGStab(l) solver
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations, each of which performs l BiCG steps.
+ * @param l The degree of the stabilizing polynomial.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void Bicgstabl(
+    T *val, int *cind, int *rptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int l, int N, T epsilon)
+{
+    T *R     = new T[N*(l+1)];
+    T *U     = new T[N*(l+1)];
+    T *rstr  = new T[N];
+    T *red   = new T[helper::MaxThreads()*(l+1)];
+    utils::Set<T>(0, &U[0], N);
+
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T *Z     = new T[(l+1)*(l+1)];
+        T *G     = new T[l*l];
+        T *z0    = new T[l];
+        T *gamma = new T[l];
+        T alpha = 0, beta, omega = 1;
+        T rho0 = 1, rho1;
+        T nrm_r = nrm_b;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, &R[0], N);
+        blas1::orphan::Axpby<T>(1, b, -1, &R[0], N);
+        blas1::orphan::Copy<T>(&R[0], rstr, N);
+        for(i=0; i<max_iter; i++) {
+            rho0 = -omega * rho0;
+            // BiCG part
+            for(int j=0; j<l; j++) {
+                rho1 = blas1::orphan::Dot<T>(&R[j*N], rstr, red, N);
+                beta = alpha * rho1 / rho0;
+                rho0 = rho1;
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpby<T>(1, &R[k*N], -beta, &U[k*N], N);
+                }
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &U[j*N], &U[(j+1)*N], N);
+                alpha = rho0 / blas1::orphan::Dot<T>(&U[(j+1)*N], rstr, red, N);
+                blas1::orphan::Axpy<T>(alpha, &U[0], x, N);
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpy<T>(-alpha, &U[(k+1)*N], &R[k*N], N);
+                }
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &R[j*N], &R[(j+1)*N], N);
+            }
+            // MR part: minimize the residual over R[1..l] by the normal equations
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Mdot<T>(R, &R[j*N], &Z[j*(l+1)], red, j+1, N);
+            }
+            for(int j=1; j<=l; j++) {
+                for(int k=1; k<=j; k++) {
+                    G[(j-1)*l+k-1] = Z[j*(l+1)+k];
+                    G[(k-1)*l+j-1] = Z[j*(l+1)+k];
+                }
+                z0[j-1] = Z[j*(l+1)];
+            }
+            blas2::Gesv<T>(G, z0, gamma, l);
+            omega = gamma[l-1];
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(gamma[j-1], &R[(j-1)*N], x, N);
+            }
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(-gamma[j-1], &R[j*N], &R[0], N);
+                blas1::orphan::Axpy<T>(-gamma[j-1], &U[j*N], &U[0], N);
+            }
+            nrm_r = blas1::orphan::Nrm2<T>(&R[0], red, N);
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, (i+1)*l, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("%s iter %d\n", ITER_SYMBOL, (i+1)*l);
+                    printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i*l);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] Z;
+        delete[] G;
+        delete[] z0;
+        delete[] gamma;
+    }
+    delete[] R;
+    delete[] U;
+    delete[] rstr;
+    delete[] red;
+}
+/**
+ * @brief ILU preconditioned BiCGStab(l) solver
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param lval Same as val, but for the matrix L.
+ * @param lcind Same as cind, but for the matrix L.
+ * @param lrptr Same as rptr, but for the matrix L.
+ * @param uval Same as val, but for the matrix U.
+ * @param ucind Same as cind, but for the matrix U.
+ * @param urptr Same as rptr, but for the matrix U.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations, each of which performs l BiCG steps.
+ * @param l The degree of the stabilizing polynomial.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void IluBicgstabl(
+    T *val, int *cind, int *rptr,
+    T *lval, int *lcind, int *lrptr,
+    T *uval, int *ucind, int *urptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int l, int N, T epsilon)
+{
+    T *R     = new T[N*(l+1)];
+    T *U     = new T[N*(l+1)];
+    T *rstr  = new T[N];
+    T *xh    = new T[N];
+    T *t     = new T[N];
+    T *red   = new T[helper::MaxThreads()*(l+1)];
+    utils::Set<T>(0, &U[0], N);
+    utils::Set<T>(0, xh, N);
+
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T *Z     = new T[(l+1)*(l+1)];
+        T *G     = new T[l*l];
+        T *z0    = new T[l];
+        T *gamma = new T[l];
+        T alpha = 0, beta, omega = 1;
+        T rho0 = 1, rho1;
+        T nrm_r = nrm_b;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, &R[0], N);
+        blas1::orphan::Axpby<T>(1, b, -1, &R[0], N);
+        blas1::orphan::Copy<T>(&R[0], rstr, N);
+        for(i=0; i<max_iter; i++) {
+            rho0 = -omega * rho0;
+            // BiCG part
+            for(int j=0; j<l; j++) {
+                rho1 = blas1::orphan::Dot<T>(&R[j*N], rstr, red, N);
+                beta = alpha * rho1 / rho0;
+                rho0 = rho1;
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpby<T>(1, &R[k*N], -beta, &U[k*N], N);
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, &U[j*N], t, N);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, &U[(j+1)*N], N);
+                alpha = rho0 / blas1::orphan::Dot<T>(&U[(j+1)*N], rstr, red, N);
+                blas1::orphan::Axpy<T>(alpha, &U[0], xh, N);
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpy<T>(-alpha, &U[(k+1)*N], &R[k*N], N);
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, &R[j*N], t, N);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, &R[(j+1)*N], N);
+            }
+            // MR part: minimize the residual over R[1..l] by the normal equations
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Mdot<T>(R, &R[j*N], &Z[j*(l+1)], red, j+1, N);
+            }
+            for(int j=1; j<=l; j++) {
+                for(int k=1; k<=j; k++) {
+                    G[(j-1)*l+k-1] = Z[j*(l+1)+k];
+                    G[(k-1)*l+j-1] = Z[j*(l+1)+k];
+                }
+                z0[j-1] = Z[j*(l+1)];
+            }
+            blas2::Gesv<T>(G, z0, gamma, l);
+            omega = gamma[l-1];
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(gamma[j-1], &R[(j-1)*N], xh, N);
+            }
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(-gamma[j-1], &R[j*N], &R[0], N);
+                blas1::orphan::Axpy<T>(-gamma[j-1], &U[j*N], &U[0], N);
+            }
+            nrm_r = blas1::orphan::Nrm2<T>(&R[0], red, N);
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, (i+1)*l, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("%s iter %d\n", ITER_SYMBOL, (i+1)*l);
+                    printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+        }
+        sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, xh, t, N);
+        sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
+        blas1::orphan::Axpy<T>(1, t, x, N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i*l);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] Z;
+        delete[] G;
+        delete[] z0;
+        delete[] gamma;
+    }
+    delete[] R;
+    delete[] U;
+    delete[] rstr;
+    delete[] xh;
+    delete[] t;
+    delete[] red;
+}
+/**
+ * @brief ILU preconditioned BiCGStab(l) solver parallelized by ABMC ordering
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param lval Same as val, but for the matrix L.
+ * @param lcind Same as cind, but for the matrix L.
+ * @param lrptr Same as rptr, but for the matrix L.
+ * @param uval Same as val, but for the matrix U.
+ * @param ucind Same as cind, but for the matrix U.
+ * @param urptr Same as rptr, but for the matrix U.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ * @param bsize The number of rows/columns of the blocks used in ABMC.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations, each of which performs l BiCG steps.
+ * @param l The degree of the stabilizing polynomial.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void AbmcIluBicgstabl(
+    T *val, int *cind, int *rptr,
+    T *lval, int *lcind, int *lrptr,
+    T *uval, int *ucind, int *urptr,
+    int *cptr, int cnum, int bsize,
+    T *b, T *x, T nrm_b,
+    int max_iter, int l, int N, T epsilon)
+{
+    T *R     = new T[N*(l+1)];
+    T *U     = new T[N*(l+1)];
+    T *rstr  = new T[N];
+    T *xh    = new T[N];
+    T *t     = new T[N];
+    T *red   = new T[helper::MaxThreads()*(l+1)];
+    utils::Set<T>(0, &U[0], N);
+    utils::Set<T>(0, xh, N);
+
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T *Z     = new T[(l+1)*(l+1)];
+        T *G     = new T[l*l];
+        T *z0    = new T[l];
+        T *gamma = new T[l];
+        T alpha = 0, beta, omega = 1;
+        T rho0 = 1, rho1;
+        T nrm_r = nrm_b;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, &R[0], N);
+        blas1::orphan::Axpby<T>(1, b, -1, &R[0], N);
+        blas1::orphan::Copy<T>(&R[0], rstr, N);
+        for(i=0; i<max_iter; i++) {
+            rho0 = -omega * rho0;
+            // BiCG part
+            for(int j=0; j<l; j++) {
+                rho1 = blas1::orphan::Dot<T>(&R[j*N], rstr, red, N);
+                beta = alpha * rho1 / rho0;
+                rho0 = rho1;
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpby<T>(1, &R[k*N], -beta, &U[k*N], N);
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, &U[j*N], t, N, cptr, cnum, bsize);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, &U[(j+1)*N], N);
+                alpha = rho0 / blas1::orphan::Dot<T>(&U[(j+1)*N], rstr, red, N);
+                blas1::orphan::Axpy<T>(alpha, &U[0], xh, N);
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpy<T>(-alpha, &U[(k+1)*N], &R[k*N], N);
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, &R[j*N], t, N, cptr, cnum, bsize);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, &R[(j+1)*N], N);
+            }
+            // MR part: minimize the residual over R[1..l] by the normal equations
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Mdot<T>(R, &R[j*N], &Z[j*(l+1)], red, j+1, N);
+            }
+            for(int j=1; j<=l; j++) {
+                for(int k=1; k<=j; k++) {
+                    G[(j-1)*l+k-1] = Z[j*(l+1)+k];
+                    G[(k-1)*l+j-1] = Z[j*(l+1)+k];
+                }
+                z0[j-1] = Z[j*(l+1)];
+            }
+            blas2::Gesv<T>(G, z0, gamma, l);
+            omega = gamma[l-1];
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(gamma[j-1], &R[(j-1)*N], xh, N);
+            }
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(-gamma[j-1], &R[j*N], &R[0], N);
+                blas1::orphan::Axpy<T>(-gamma[j-1], &U[j*N], &U[0], N);
+            }
+            nrm_r = blas1::orphan::Nrm2<T>(&R[0], red, N);
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, (i+1)*l, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("%s iter %d\n", ITER_SYMBOL, (i+1)*l);
+                    printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+        }
+        sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, xh, t, N, cptr, cnum, bsize);
+        sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
+        blas1::orphan::Axpy<T>(1, t, x, N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i*l);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] Z;
+        delete[] G;
+        delete[] z0;
+        delete[] gamma;
+    }
+    delete[] R;
+    delete[] U;
+    delete[] rstr;
+    delete[] xh;
+    delete[] t;
+    delete[] red;
+}
+/**
+ * @brief ILUB preconditioned BiCGStab(l) solver
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param blval values of L in the BCSR format.
+ * @param blcind colum positions of blocks of L in the BCSR format.
+ * @param blrptr starting positions of row blocks of L in the BCSR format.
+ * @param buval values of U in the BCSR format.
+ * @param bucind colum positions of blocks of U in the BCSR format.
+ * @param burptr starting positions of row blocks of U in the BCSR format.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations, each of which performs l BiCG steps.
+ * @param l The degree of the stabilizing polynomial.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, int bnl, int bnw>
+void IlubBicgstabl(
+    T *val, int *cind, int *rptr,
+    T *blval, int *blcind, int *blrptr,
+    T *buval, int *bucind, int *burptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int l, int N, T epsilon)
+{
+    T *R     = new T[N*(l+1)];
+    T *U     = new T[N*(l+1)];
+    T *rstr  = new T[N];
+    T *xh    = new T[N];
+    T *t     = new T[N];
+    T *red   = new T[helper::MaxThreads()*(l+1)];
+    utils::Set<T>(0, &U[0], N);
+    utils::Set<T>(0, xh, N);
+
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T *Z     = new T[(l+1)*(l+1)];
+        T *G     = new T[l*l];
+        T *z0    = new T[l];
+        T *gamma = new T[l];
+        T alpha = 0, beta, omega = 1;
+        T rho0 = 1, rho1;
+        T nrm_r = nrm_b;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, &R[0], N);
+        blas1::orphan::Axpby<T>(1, b, -1, &R[0], N);
+        blas1::orphan::Copy<T>(&R[0], rstr, N);
+        for(i=0; i<max_iter; i++) {
+            rho0 = -omega * rho0;
+            // BiCG part
+            for(int j=0; j<l; j++) {
+                rho1 = blas1::orphan::Dot<T>(&R[j*N], rstr, red, N);
+                beta = alpha * rho1 / rho0;
+                rho0 = rho1;
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpby<T>(1, &R[k*N], -beta, &U[k*N], N);
+                }
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, &U[j*N], t, N);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, &U[(j+1)*N], N);
+                alpha = rho0 / blas1::orphan::Dot<T>(&U[(j+1)*N], rstr, red, N);
+                blas1::orphan::Axpy<T>(alpha, &U[0], xh, N);
+                for(int k=0; k<=j; k++) {
+                    blas1::orphan::Axpy<T>(-alpha, &U[(k+1)*N], &R[k*N], N);
+                }
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, &R[j*N], t, N);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, &R[(j+1)*N], N);
+            }
+            // MR part: minimize the residual over R[1..l] by the normal equations
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Mdot<T>(R, &R[j*N], &Z[j*(l+1)], red, j+1, N);
+            }
+            for(int j=1; j<=l; j++) {
+                for(int k=1; k<=j; k++) {
+                    G[(j-1)*l+k-1] = Z[j*(l+1)+k];
+                    G[(k-1)*l+j-1] = Z[j*(l+1)+k];
+                }
+                z0[j-1] = Z[j*(l+1)];
+            }
+            blas2::Gesv<T>(G, z0, gamma, l);
+            omega = gamma[l-1];
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(gamma[j-1], &R[(j-1)*N], xh, N);
+            }
+            for(int j=1; j<=l; j++) {
+                blas1::orphan::Axpy<T>(-gamma[j-1], &R[j*N], &R[0], N);
+                blas1::orphan::Axpy<T>(-gamma[j-1], &U[j*N], &U[0], N);
+            }
+            nrm_r = blas1::orphan::Nrm2<T>(&R[0], red, N);
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, (i+1)*l, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("%s iter %d\n", ITER_SYMBOL, (i+1)*l);
+                    printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+        }
+        sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, xh, t, N);
+        sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
+        blas1::orphan::Axpy<T>(1, t, x, N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i*l);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] Z;
+        delete[] G;
+        delete[] z0;
+        delete[] gamma;
+    }
+    delete[] R;
+    delete[] U;
+    delete[] rstr;
+    delete[] xh;
+    delete[] t;
+    delete[] red;
 }
 
 //
@@ -81,6 +81,60 @@ void Axpyz(T a, T *x, T *y, T *z, int N) {
     #pragma omp parallel for simd
     for(int i=0; i<N; i++) { z[i] = a * x[i] + y[i]; }
 }
+/**
+ * @brief Compute z = a * x + b * y + c * z.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param b A scalar value.
+ * @param y A 1D-array of size N.
+ * @param c A scalar value.
+ * @param z A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Axpbypcz(T a, T *x, T b, T *y, T c, T *z, int N) {
+    #pragma omp parallel for simd
+    for(int i=0; i<N; i++) { z[i] = a * x[i] + b * y[i] + c * z[i]; }
+}
+/**
+ * @brief Compute y = a * x + y and w = b * z + w in a single sweep.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param b A scalar value.
+ * @param z A 1D-array of size N.
+ * @param w A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void AxpyPair(T a, T *x, T *y, T b, T *z, T *w, int N) {
+    #pragma omp parallel for simd
+    for(int i=0; i<N; i++) {
+        y[i] += a * x[i];
+        w[i] += b * z[i];
+    }
+}
+/**
+ * @brief Compute z = y + X * a, where X holds n vectors, in a single sweep.
+ * @tparam T The type of vectors.
+ * @param X A 1D-array of size n * N that stores n vectors consecutively.
+ * @param a A 1D-array of size n.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param n The number of vectors stored in X.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Maxpyz(T *X, T *a, T *y, T *z, int n, int N) {
+    #pragma omp parallel for simd
+    for(int i=0; i<N; i++) {
+        T temp = y[i];
+        for(int k=0; k<n; k++) { temp += a[k] * X[k*N+i]; }
+        z[i] = temp;
+    }
+}
 /**
  * @brief Compute the dot product of x and y.
  * @tparam T The type of vectors.
@@ -96,6 +150,68 @@ T Dot(T *x, T *y, int N) {
     for(int i=0; i<N; i++) { res += x[i] * y[i]; }
     return res;
 }
+/**
+ * @brief Compute the dot products of x and y and of x and z in a single sweep.
+ * @tparam T The type of vectors.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param res A 1D-array of size 2 to receive x*y and x*z.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void DotPair(T *x, T *y, T *z, T *res, int N) {
+    T xy = 0, xz = 0;
+    #pragma omp parallel for simd reduction(+: xy, xz)
+    for(int i=0; i<N; i++) {
+        xy += x[i] * y[i];
+        xz += x[i] * z[i];
+    }
+    res[0] = xy;
+    res[1] = xz;
+}
+/**
+ * @brief Compute z = a * x + y, and then z*z and z*w in the same sweep.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param w A 1D-array of size N.
+ * @param res A 1D-array of size 2 to receive z*z and z*w.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void AxpyzDotPair(T a, T *x, T *y, T *z, T *w, T *res, int N) {
+    T zz = 0, zw = 0;
+    #pragma omp parallel for simd reduction(+: zz, zw)
+    for(int i=0; i<N; i++) {
+        T temp = a * x[i] + y[i];
+        z[i] = temp;
+        zz += temp * temp;
+        zw += temp * w[i];
+    }
+    res[0] = zz;
+    res[1] = zw;
+}
+/**
+ * @brief Compute the dot products of n vectors and y in a single sweep.
+ * @tparam T The type of vectors.
+ * @param X A 1D-array of size n * N that stores n vectors consecutively.
+ * @param y A 1D-array of size N.
+ * @param res A 1D-array of size n to receive the dot products.
+ * @param n The number of vectors stored in X.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Mdot(T *X, T *y, T *res, int n, int N) {
+    for(int k=0; k<n; k++) { res[k] = 0; }
+    #pragma omp parallel for reduction(+: res[:n])
+    for(int i=0; i<N; i++) {
+        T temp = y[i];
+        for(int k=0; k<n; k++) { res[k] += X[k*N+i] * temp; }
+    }
+}
 /**
  * @brief Compute the 2-norm of x.
  * @tparam T The type of the vector.
@@ -166,6 +282,284 @@ void Grot(T c, T s, T *a, T *b)
     a[0] = c * temp - s * b[0];
     b[0] = s * temp + c * b[0];
 }
+/**
+ * @brief Orphaned versions of the Level1 BLAS-style functions.
+ * @details These functions must be called by all threads of an enclosing
+ * parallel region. They end with a barrier, so the results are visible to
+ * the whole team on return. The reductions give the same value to every
+ * thread; red is a shared array with one slot per thread (n slots for Mdot).
+ */
+namespace orphan {
+/**
+ * @brief Sum up values held by each thread and give the sums to all threads.
+ * @tparam T The type of values.
+ * @param val A 1D-array of size n held by the calling thread.
+ * @param res A 1D-array of size n to receive the sums.
+ * @param red A shared 1D-array of size n * (the number of threads).
+ * @param n The number of values.
+ */
+template <typename T> inline
+void Allreduce(T *val, T *res, T *red, int n) {
+    int nt = helper::NumThreads();
+    int tid = helper::ThreadId();
+    for(int k=0; k<n; k++) { red[tid*n+k] = val[k]; }
+    #pragma omp barrier
+    for(int k=0; k<n; k++) {
+        T temp = 0;
+        for(int t=0; t<nt; t++) { temp += red[t*n+k]; }
+        res[k] = temp;
+    }
+    #pragma omp barrier
+}
+/**
+ * @brief Copy x to y.
+ * @tparam T The type of vectors.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Copy(T *x, T *y, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { y[i] = x[i]; }
+}
+/**
+ * @brief Multiply x by a.
+ * @tparam T The type of a vector.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param N The size of a vector.
+ */
+template <typename T> inline
+void Scal(T a, T *x, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { x[i] *= a; }
+}
+/**
+ * @brief Scale x by a and store a copy of the result in y.
+ * @tparam T The type of x.
+ * @tparam TY The type of y, which may be narrower than T.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T, typename TY = T> inline
+void ScalCopy(T a, T *x, TY *y, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) {
+        x[i] *= a;
+        y[i] = x[i];
+    }
+}
+/**
+ * @brief Compute y = a * x + y.
+ * @tparam T The type of y.
+ * @tparam TX The type of x, which may be narrower than T.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T, typename TX = T> inline
+void Axpy(T a, TX *x, T *y, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { y[i] += a * x[i]; }
+}
+/**
+ * @brief Compute y = a * x + b * y.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param b A scalar value.
+ * @param y A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Axpby(T a, T *x, T b, T *y, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { y[i] = a * x[i] + b * y[i]; }
+}
+/**
+ * @brief Compute z = a * x + y.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Axpyz(T a, T *x, T *y, T *z, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { z[i] = a * x[i] + y[i]; }
+}
+/**
+ * @brief Compute z = a * x + b * y + c * z.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param b A scalar value.
+ * @param y A 1D-array of size N.
+ * @param c A scalar value.
+ * @param z A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Axpbypcz(T a, T *x, T b, T *y, T c, T *z, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { z[i] = a * x[i] + b * y[i] + c * z[i]; }
+}
+/**
+ * @brief Compute y = a * x + y and w = b * z + w in a single sweep.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param b A scalar value.
+ * @param z A 1D-array of size N.
+ * @param w A 1D-array of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void AxpyPair(T a, T *x, T *y, T b, T *z, T *w, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) {
+        y[i] += a * x[i];
+        w[i] += b * z[i];
+    }
+}
+/**
+ * @brief Compute z = y + X * a, where X holds n vectors, in a single sweep.
+ * @tparam T The type of vectors.
+ * @param X A 1D-array of size n * N that stores n vectors consecutively.
+ * @param a A 1D-array of size n.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param n The number of vectors stored in X.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Maxpyz(T *X, T *a, T *y, T *z, int n, int N) {
+    #pragma omp for simd
+    for(int i=0; i<N; i++) {
+        T temp = y[i];
+        for(int k=0; k<n; k++) { temp += a[k] * X[k*N+i]; }
+        z[i] = temp;
+    }
+}
+/**
+ * @brief Compute the dot product of x and y.
+ * @tparam T The type of y and of the result.
+ * @tparam TX The type of x, which may be narrower than T.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param red A shared work array.
+ * @param N The size of vectors.
+ * @return The resulting dot product.
+ */
+template <typename T, typename TX = T> inline
+T Dot(TX *x, T *y, T *red, int N) {
+    int start, end;
+    helper::ThreadRange(N, &start, &end);
+    T temp = 0;
+    #pragma omp simd reduction(+: temp)
+    for(int i=start; i<end; i++) { temp += x[i] * y[i]; }
+    T res;
+    Allreduce<T>(&temp, &res, red, 1);
+    return res;
+}
+/**
+ * @brief Compute the 2-norm of x.
+ * @tparam T The type of the vector.
+ * @param x A 1D-array of size N.
+ * @param red A shared work array.
+ * @param N The size of the vector.
+ * @return 2-norm of x.
+ */
+template <typename T> inline
+T Nrm2(T *x, T *red, int N) {
+    return std::sqrt(Dot<T>(x, x, red, N));
+}
+/**
+ * @brief Compute the dot products of x and y and of x and z in a single sweep.
+ * @tparam T The type of vectors.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param res A 1D-array of size 2 to receive x*y and x*z.
+ * @param red A shared work array.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void DotPair(T *x, T *y, T *z, T *res, T *red, int N) {
+    int start, end;
+    helper::ThreadRange(N, &start, &end);
+    T temp[2];
+    T xy = 0, xz = 0;
+    #pragma omp simd reduction(+: xy, xz)
+    for(int i=start; i<end; i++) {
+        xy += x[i] * y[i];
+        xz += x[i] * z[i];
+    }
+    temp[0] = xy;
+    temp[1] = xz;
+    Allreduce<T>(temp, res, red, 2);
+}
+/**
+ * @brief Compute z = a * x + y, and then z*z and z*w in the same sweep.
+ * @tparam T The type of vectors.
+ * @param a A scalar value.
+ * @param x A 1D-array of size N.
+ * @param y A 1D-array of size N.
+ * @param z A 1D-array of size N.
+ * @param w A 1D-array of size N.
+ * @param res A 1D-array of size 2 to receive z*z and z*w.
+ * @param red A shared work array.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void AxpyzDotPair(T a, T *x, T *y, T *z, T *w, T *res, T *red, int N) {
+    int start, end;
+    helper::ThreadRange(N, &start, &end);
+    T temp[2];
+    T zz = 0, zw = 0;
+    #pragma omp simd reduction(+: zz, zw)
+    for(int i=start; i<end; i++) {
+        T t = a * x[i] + y[i];
+        z[i] = t;
+        zz += t * t;
+        zw += t * w[i];
+    }
+    temp[0] = zz;
+    temp[1] = zw;
+    Allreduce<T>(temp, res, red, 2);
+}
+/**
+ * @brief Compute the dot products of n vectors and y in a single sweep.
+ * @tparam T The type of vectors.
+ * @param X A 1D-array of size n * N that stores n vectors consecutively.
+ * @param y A 1D-array of size N.
+ * @param res A 1D-array of size n to receive the dot products.
+ * @param red A shared work array.
+ * @param n The number of vectors stored in X.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void Mdot(T *X, T *y, T *res, T *red, int n, int N) {
+    int start, end;
+    helper::ThreadRange(N, &start, &end);
+    int tid = helper::ThreadId();
+    for(int k=0; k<n; k++) {
+        T temp = 0;
+        #pragma omp simd reduction(+: temp)
+        for(int i=start; i<end; i++) { temp += X[k*N+i] * y[i]; }
+        red[tid*n+k] = temp;
+    }
+    Allreduce<T>(&red[tid*n], res, red, n);
+}
+
+} // namespace orphan
 
 }
 
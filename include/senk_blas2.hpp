@@ -7,6 +7,10 @@
 #ifndef SENK_BLAS2_HPP
 #define SENK_BLAS2_HPP
 
+#include <cmath>
+
+#include "senk_helper.hpp"
+
 namespace senk {
 /**
  * @brief This namespace contains Level2 BLAS-style functions.
@@ -32,6 +36,236 @@ void Trsv(T *U, T *b, T *x, int n, int m)
         x[i] = temp / U[i*n+i];
     }
 }
+/**
+ * @brief LU factorization with partial pivoting of a small dense matrix.
+ * @details A is overwritten by the unit lower factor (without its diagonal)
+ * and the upper factor.
+ * @tparam T The type of the matrix.
+ * @param A A 2D-array of size n * n stored in column-major order.
+ * @param piv A 1D-array of size n to receive the pivot rows.
+ * @param n The number of rows/columns of the matrix.
+ */
+template <typename T> inline
+void Getrf(T *A, int *piv, int n)
+{
+    for(int k=0; k<n; k++) {
+        int p = k;
+        for(int i=k+1; i<n; i++) {
+            if(std::abs(A[k*n+i]) > std::abs(A[k*n+p])) p = i;
+        }
+        piv[k] = p;
+        if(p != k) {
+            for(int j=0; j<n; j++) { helper::Swap<T>(&A[j*n+k], &A[j*n+p]); }
+        }
+        for(int i=k+1; i<n; i++) {
+            A[k*n+i] /= A[k*n+k];
+            T l = A[k*n+i];
+            for(int j=k+1; j<n; j++) { A[j*n+i] -= l * A[j*n+k]; }
+        }
+    }
+}
+/**
+ * @brief Solve a small dense system with the factors given by Getrf.
+ * @tparam T The type of vectors.
+ * @param A A 2D-array of size n * n that holds the factors.
+ * @param piv A 1D-array of size n that holds the pivot rows.
+ * @param b A 1D-array of size n.
+ * @param x A 1D-array of size n to receive the solution. x may be b.
+ * @param n The number of rows/columns of the matrix.
+ */
+template <typename T> inline
+void Getrs(T *A, int *piv, T *b, T *x, int n)
+{
+    if(x != b) {
+        for(int i=0; i<n; i++) { x[i] = b[i]; }
+    }
+    // Getrf swaps whole rows, so the multipliers are in the final pivot
+    // order and all the swaps are applied before the forward sweep.
+    for(int k=0; k<n; k++) {
+        if(piv[k] != k) helper::Swap<T>(&x[k], &x[piv[k]]);
+    }
+    for(int k=0; k<n; k++) {
+        for(int i=k+1; i<n; i++) { x[i] -= A[k*n+i] * x[k]; }
+    }
+    Trsv<T>(A, x, x, n, n);
+}
+/**
+ * @brief Solve a small dense system by Gaussian elimination with partial pivoting.
+ * @details A and b are overwritten.
+ * @tparam T The type of vectors.
+ * @param A A 2D-array of size n * n stored in column-major order.
+ * @param b A 1D-array of size n.
+ * @param x A 1D-array of size n to receive the solution.
+ * @param n The number of rows/columns of the matrix.
+ */
+template <typename T> inline
+void Gesv(T *A, T *b, T *x, int n)
+{
+    int *piv = new int[n];
+    Getrf<T>(A, piv, n);
+    Getrs<T>(A, piv, b, b, n);
+    for(int i=0; i<n; i++) { x[i] = b[i]; }
+    delete[] piv;
+}
+/**
+ * @brief Solve a small dense least-squares problem, min ||A x - b||, by the Householder QR factorization.
+ * @details A and b are overwritten. A must have full column rank.
+ * @tparam T The type of vectors.
+ * @param A A 2D-array of size m * n stored in column-major order (m >= n).
+ * @param b A 1D-array of size m.
+ * @param x A 1D-array of size n to receive the solution.
+ * @param m The number of rows of the matrix.
+ * @param n The number of columns of the matrix.
+ */
+template <typename T> inline
+void Gels(T *A, T *b, T *x, int m, int n)
+{
+    for(int k=0; k<n; k++) {
+        T *v = &A[k*m];
+        T nrm = 0;
+        for(int i=k; i<m; i++) { nrm += v[i] * v[i]; }
+        nrm = std::sqrt(nrm);
+        if(nrm == 0) continue;
+        T alpha = (v[k] > 0) ? -nrm : nrm;
+        v[k] -= alpha;
+        T vv = 0;
+        for(int i=k; i<m; i++) { vv += v[i] * v[i]; }
+        for(int j=k+1; j<n; j++) {
+            T s = 0;
+            for(int i=k; i<m; i++) { s += v[i] * A[j*m+i]; }
+            s = 2 * s / vv;
+            for(int i=k; i<m; i++) { A[j*m+i] -= s * v[i]; }
+        }
+        T s = 0;
+        for(int i=k; i<m; i++) { s += v[i] * b[i]; }
+        s = 2 * s / vv;
+        for(int i=k; i<m; i++) { b[i] -= s * v[i]; }
+        v[k] = alpha;
+    }
+    Trsv<T>(A, b, x, m, n);
+}
+/**
+ * @brief Estimate the spectral radius of a small dense matrix by the power method.
+ * @details The growth factor of the iterates is averaged geometrically over
+ * the second half of the iterations, so that a dominant complex conjugate
+ * pair, for which the iterates do not converge, is also handled.
+ * @tparam T The type of the matrix.
+ * @param A A 2D-array of size lda * n stored in column-major order.
+ * @param lda The leading dimension of A.
+ * @param n The number of rows/columns of the matrix.
+ * @param iter The number of iterations.
+ * @return The estimated spectral radius.
+ */
+template <typename T> inline
+T SpectralRadius(T *A, int lda, int n, int iter)
+{
+    T *v = new T[n];
+    T *w = new T[n];
+    for(int i=0; i<n; i++) { v[i] = 1 + (T)i / n; }
+    T sum = 0;
+    int cnt = 0;
+    for(int it=0; it<iter; it++) {
+        for(int i=0; i<n; i++) { w[i] = 0; }
+        for(int j=0; j<n; j++) {
+            for(int i=0; i<n; i++) { w[i] += A[j*lda+i] * v[j]; }
+        }
+        T nrm = 0;
+        for(int i=0; i<n; i++) { nrm += w[i] * w[i]; }
+        nrm = std::sqrt(nrm);
+        if(nrm == 0) { sum = 0; cnt = 0; break; }
+        for(int i=0; i<n; i++) { v[i] = w[i] / nrm; }
+        if(it >= iter/2) {
+            sum += std::log(nrm);
+            cnt++;
+        }
+    }
+    delete[] v;
+    delete[] w;
+    return (cnt == 0) ? 0 : std::exp(sum / cnt);
+}
+/**
+ * @brief Compute y = beta * y + A * x in a single sweep over A.
+ * @details The rows are processed in blocks of bs rows. Each block of y is
+ * accumulated in a local buffer while the columns of A are streamed through
+ * it, so y is read and written only once. y may be one of the columns of A.
+ * @tparam T The type of vectors.
+ * @tparam bs The number of rows of a block.
+ * @tparam TA The type of A, which may be narrower than T.
+ * @param A A 2D-array of size N * n stored in column-major order.
+ * @param x A 1D-array of size n.
+ * @param beta A scalar value. When beta is 0, y is not read.
+ * @param y A 1D-array of size N.
+ * @param n The number of columns of the matrix.
+ * @param N The number of rows of the matrix.
+ */
+template <typename T, int bs = 256, typename TA = T> inline
+void Gemv(TA *A, T *x, T beta, T *y, int n, int N)
+{
+    #pragma omp parallel for
+    for(int ib=0; ib<N; ib+=bs) {
+        int len = (N-ib < bs) ? N-ib : bs;
+        T temp[bs];
+        if(beta == 0) {
+            #pragma omp simd
+            for(int i=0; i<len; i++) { temp[i] = 0; }
+        }else {
+            #pragma omp simd
+            for(int i=0; i<len; i++) { temp[i] = beta * y[ib+i]; }
+        }
+        for(int k=0; k<n; k++) {
+            T a = x[k];
+            TA *col = &A[k*N+ib];
+            #pragma omp simd
+            for(int i=0; i<len; i++) { temp[i] += a * col[i]; }
+        }
+        #pragma omp simd
+        for(int i=0; i<len; i++) { y[ib+i] = temp[i]; }
+    }
+}
+/**
+ * @brief Orphaned versions of the Level2 BLAS-style functions.
+ * @details These functions must be called by all threads of an enclosing
+ * parallel region and end with a barrier.
+ */
+namespace orphan {
+/**
+ * @brief Compute y = beta * y + A * x in a single sweep over A.
+ * @tparam T The type of vectors.
+ * @tparam bs The number of rows of a block.
+ * @tparam TA The type of A, which may be narrower than T.
+ * @param A A 2D-array of size N * n stored in column-major order.
+ * @param x A 1D-array of size n.
+ * @param beta A scalar value. When beta is 0, y is not read.
+ * @param y A 1D-array of size N.
+ * @param n The number of columns of the matrix.
+ * @param N The number of rows of the matrix.
+ */
+template <typename T, int bs = 256, typename TA = T> inline
+void Gemv(TA *A, T *x, T beta, T *y, int n, int N)
+{
+    #pragma omp for
+    for(int ib=0; ib<N; ib+=bs) {
+        int len = (N-ib < bs) ? N-ib : bs;
+        T temp[bs];
+        if(beta == 0) {
+            #pragma omp simd
+            for(int i=0; i<len; i++) { temp[i] = 0; }
+        }else {
+            #pragma omp simd
+            for(int i=0; i<len; i++) { temp[i] = beta * y[ib+i]; }
+        }
+        for(int k=0; k<n; k++) {
+            T a = x[k];
+            TA *col = &A[k*N+ib];
+            #pragma omp simd
+            for(int i=0; i<len; i++) { temp[i] += a * col[i]; }
+        }
+        #pragma omp simd
+        for(int i=0; i<len; i++) { y[ib+i] = temp[i]; }
+    }
+}
+
+} // namespace orphan
 
 }
 
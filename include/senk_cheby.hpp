@@ -0,0 +1,399 @@
+/**
+ * @file senk_cheby.hpp
+ * @brief The Chebyshev polynomial preconditioned solvers and the spectrum estimation are defined.
+ * @author Kengo Suzuki
+ * @date 5/8/2021
+ */
+#ifndef SENK_CHEBY_HPP
+#define SENK_CHEBY_HPP
+
+#include <cmath>
+#include <random>
+
+#include "senk_sparse.hpp"
+#include "senk_blas1.hpp"
+#include "senk_blas2.hpp"
+#include "senk_helper.hpp"
+
+namespace senk {
+
+namespace solver {
+/**
+ * @brief Estimate the interval [lmin, lmax] for the Chebyshev preconditioner.
+ * @details m Arnoldi steps are applied to a random vector in the same way as
+ * in Gmresm. lmax is the spectral radius of the resulting Hessenberg matrix
+ * and lmin is the inverse of the spectral radius of its inverse. lmax is
+ * enlarged by 10% since the Ritz values approach the extreme eigenvalues from
+ * inside.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param lmin The estimated lower bound of the spectrum.
+ * @param lmax The estimated upper bound of the spectrum.
+ * @param m The number of Arnoldi steps.
+ * @param N The size of the matrix and the vectors.
+ */
+template <typename T>
+void EstimateSpectrum(
+    T *val, int *cind, int *rptr,
+    T *lmin, T *lmax, int m, int N)
+{
+    T *V  = new T[N*(m+1)];
+    T *H  = new T[(m+1)*m];
+    T *Hm = new T[m*m];
+    T *Hi = new T[m*m];
+    T *A  = new T[m*m];
+    int *piv = new int[m];
+
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<T> dist(-1.0, 1.0);
+    for(int i=0; i<N; i++) { V[i] = dist(engine); }
+    blas1::Scal<T>(1/blas1::Nrm2<T>(&V[0], N), &V[0], N);
+    int j;
+    for(j=0; j<m; j++) {
+        sparse::SpmvCsr<T>(val, cind, rptr, &V[j*N], &V[(j+1)*N], N);
+        for(int k=0; k<=j; k++) {
+            H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
+            blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
+        }
+        H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
+        if(H[j*(m+1)+j+1] == 0) { j++; break; }
+        blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
+    }
+    // The j x j leading part of H
+    for(int c=0; c<j; c++) {
+        for(int r=0; r<j; r++) {
+            Hm[c*j+r] = (r <= c+1) ? H[c*(m+1)+r] : 0;
+        }
+    }
+    *lmax = 1.1 * blas2::SpectralRadius<T>(Hm, j, j, 200);
+    // Factor it once and invert it column by column.
+    for(int k=0; k<j*j; k++) { A[k] = Hm[k]; }
+    blas2::Getrf<T>(A, piv, j);
+    for(int c=0; c<j; c++) {
+        for(int r=0; r<j; r++) { Hi[c*j+r] = (r == c) ? 1 : 0; }
+        blas2::Getrs<T>(A, piv, &Hi[c*j], &Hi[c*j], j);
+    }
+    *lmin = 1 / blas2::SpectralRadius<T>(Hi, j, j, 200);
+
+    delete[] V;
+    delete[] H;
+    delete[] Hm;
+    delete[] Hi;
+    delete[] A;
+    delete[] piv;
+}
+/**
+ * @brief The Chebyshev polynomial preconditioned GMRES(m) solver.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param lmin The lower bound of the spectrum, e.g. given by EstimateSpectrum.
+ * @param lmax The upper bound of the spectrum, e.g. given by EstimateSpectrum.
+ * @param deg The number of Chebyshev steps in each application of the preconditioner.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, typename TV = T>
+void ChebyGmresm(
+    T *val, int *cind, int *rptr,
+    T lmin, T lmax, int deg,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *cw  = new T[3*N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::ChebyCsr<T>(val, cind, rptr, w, t, cw, lmin, lmax, deg, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
+            }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::ChebyCsr<T>(val, cind, rptr, W, t, cw, lmin, lmax, deg, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] cw;
+    delete[] red;
+}
+/**
+ * @brief The Chebyshev polynomial preconditioned GMRES(m) solver.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param bval val array of the BCSR storage format.
+ * @param bcind column index array of the BCSR storage format.
+ * @param brptr row pointer array of the BCSR storage format.
+ * @param lmin The lower bound of the spectrum, e.g. given by EstimateSpectrum.
+ * @param lmax The upper bound of the spectrum, e.g. given by EstimateSpectrum.
+ * @param deg The number of Chebyshev steps in each application of the preconditioner.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, int bnl, int bnw, typename TV = T>
+void ChebyGmresm(
+    T *bval, int *bcind, int *brptr,
+    T lmin, T lmax, int deg,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *cw  = new T[3*N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::ChebyBcsr<T, bnl, bnw>(bval, bcind, brptr, w, t, cw, lmin, lmax, deg, N);
+                sparse::orphan::SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
+            }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::ChebyBcsr<T, bnl, bnw>(bval, bcind, brptr, W, t, cw, lmin, lmax, deg, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] cw;
+    delete[] red;
+}
+/**
+ * @brief Chebyshev polynomial preconditioned BiCGStab solver
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param lmin The lower bound of the spectrum, e.g. given by EstimateSpectrum.
+ * @param lmax The upper bound of the spectrum, e.g. given by EstimateSpectrum.
+ * @param deg The number of Chebyshev steps in each application of the preconditioner.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void ChebyBicgstab(
+    T *val, int *cind, int *rptr,
+    T lmin, T lmax, int deg,
+    T *b, T *x, T nrm_b,
+    int max_iter, int N, T epsilon)
+{
+    T *r    = new T[N];
+    T *rstr = new T[N];
+    T *p    = new T[N];
+    T *Kp   = new T[N];
+    T *AKp  = new T[N];
+    T *s    = new T[N];
+    T *Ks   = new T[N];
+    T *AKs  = new T[N];
+    T *cw   = new T[3*N];
+    T *red  = new T[helper::MaxThreads()*2];
+
+    #pragma omp parallel
+    {
+        int i;
+        int flag = 0;
+        T alpha, beta, omega;
+        T dots[2];
+        T r_rstr, prev;
+        T nrm_r = nrm_b;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        blas1::orphan::Copy<T>(r, rstr, N);
+        blas1::orphan::Copy<T>(r, p, N);
+        r_rstr = blas1::orphan::Dot<T>(r, rstr, red, N);
+        for(i=0; i<max_iter; i++) {
+            sparse::orphan::ChebyCsr<T>(val, cind, rptr, p, Kp, cw, lmin, lmax, deg, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kp, AKp, N);
+            alpha = r_rstr / blas1::orphan::Dot<T>(AKp, rstr, red, N);
+            blas1::orphan::Axpyz<T>(-alpha, AKp, r, s, N);
+            sparse::orphan::ChebyCsr<T>(val, cind, rptr, s, Ks, cw, lmin, lmax, deg, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Ks, AKs, N);
+            blas1::orphan::DotPair<T>(AKs, s, AKs, dots, red, N);
+            omega = dots[0] / dots[1];
+            blas1::orphan::Axpbypcz<T>(alpha, Kp, omega, Ks, 1, x, N);
+            blas1::orphan::AxpyzDotPair<T>(-omega, AKs, s, r, rstr, dots, red, N);
+            nrm_r = std::sqrt(dots[0]);
+            #pragma omp master
+            printf("%d %e\n", i+1, nrm_r/nrm_b);
+            if(nrm_r < epsilon * nrm_b) {
+                #pragma omp master
+                {
+                    printf("# iter %d\n", i+1);
+                    printf("# res %e\n", nrm_r/nrm_b);
+                }
+                flag = 1;
+                break;
+            }
+            prev = r_rstr;
+            r_rstr = dots[1];
+            beta = alpha / omega * r_rstr / prev;
+            blas1::orphan::Axpbypcz<T>(1, r, -beta*omega, AKp, beta, p, N);
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", i);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+    }
+    delete[] r;
+    delete[] rstr;
+    delete[] p;
+    delete[] Kp;
+    delete[] AKp;
+    delete[] s;
+    delete[] Ks;
+    delete[] AKs;
+    delete[] cw;
+    delete[] red;
+}
+
+} // namespace solver
+
+} // namespace senk
+
+#endif
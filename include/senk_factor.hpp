@@ -0,0 +1,260 @@
+/**
+ * @file senk_factor.hpp
+ * @brief The ILU factorization object with a reusable symbolic phase is defined.
+ * @author Kengo Suzuki
+ * @date 5/8/2021
+ */
+#ifndef SENK_FACTOR_HPP
+#define SENK_FACTOR_HPP
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+
+#include "senk_utils.hpp"
+#include "senk_matrix.hpp"
+
+namespace senk {
+
+namespace matrix {
+/**
+ * @brief ILU(p) factors whose pattern and layouts are computed once.
+ * @details The constructor performs the symbolic phase: the fill pattern,
+ * the level schedule of the rows, the positions of the entries of A in the
+ * pattern and the positions of each factor entry in the "L-DU" CSR arrays
+ * (same as Split) and in the BCSR arrays (same as Csr2Bcsr). Refactor
+ * computes the factors for new values of A with the same pattern and writes
+ * them into the existing arrays. The rows of a level of the schedule are
+ * factorized in parallel.
+ * @tparam T The type of the matrix.
+ */
+template <typename T>
+class IluFactor {
+private:
+    //! The size of the matrix.
+    int N;
+    //! The values of the combined factors.
+    T *fval;
+    //! The column indices of the combined factors.
+    int *fcind;
+    //! The row pointer of the combined factors.
+    int *frptr;
+    //! The position of the diagonal of each row in fval.
+    int *dptr;
+    //! The row pointer of A.
+    int *arptr;
+    //! The position of each entry of A in fval.
+    int *amap;
+    //! The position of each entry of fval in lval or uval.
+    int *dst;
+    //! The position of each entry of fval in blval or buval.
+    int *bdst;
+    //! The number of levels of the schedule.
+    int num_level;
+    //! The starting position of each level in rows.
+    int *level_ptr;
+    //! The rows sorted by level.
+    int *rows;
+public:
+    //! val array of L in the CSR format.
+    T *lval;
+    //! cind array of L in the CSR format.
+    int *lcind;
+    //! rptr array of L in the CSR format.
+    int *lrptr;
+    //! val array of U, whose diagonal is inverted, in the CSR format.
+    T *uval;
+    //! cind array of U in the CSR format.
+    int *ucind;
+    //! rptr array of U in the CSR format.
+    int *urptr;
+    //! val array of L in the BCSR format.
+    T *blval;
+    //! cind array of L in the BCSR format.
+    int *blcind;
+    //! rptr array of L in the BCSR format.
+    int *blrptr;
+    //! val array of U in the BCSR format.
+    T *buval;
+    //! cind array of U in the BCSR format.
+    int *bucind;
+    //! rptr array of U in the BCSR format.
+    int *burptr;
+    /**
+     * @brief Constructor.
+     * @details Perform the symbolic phase and then Refactor.
+     * @param val val array of the CSR storage format.
+     * @param cind column index array of the CSR storage format.
+     * @param rptr row pointer array of the CSR storage format.
+     * @param a_N The size of the matrix.
+     * @param p The fill level.
+     * @param bnl The number of rows of the block of the BCSR arrays.
+     * @param bnw The number of columns of the block of the BCSR arrays.
+     */
+    IluFactor(T *val, int *cind, int *rptr, int a_N, int p, int bnl, int bnw) {
+        N = a_N;
+        IlupSymbolic(cind, rptr, &fcind, &frptr, N, p);
+        int nnz = frptr[N];
+        fval = utils::SafeCalloc<T>(nnz);
+        dptr = utils::SafeMalloc<int>(N);
+        arptr = utils::SafeMalloc<int>(N+1);
+        utils::Copy<int>(rptr, arptr, N+1);
+        amap = utils::SafeMalloc<int>(rptr[N]);
+        // Positions of the entries of A and the diagonal
+        for(int i=0; i<N; i++) {
+            int pos = frptr[i];
+            for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                while(fcind[pos] < cind[j]) pos++;
+                amap[j] = pos;
+            }
+            for(int j=frptr[i]; j<frptr[i+1]; j++) {
+                if(fcind[j] == i) dptr[i] = j;
+            }
+        }
+        // Level schedule
+        int *lev = utils::SafeMalloc<int>(N);
+        num_level = 0;
+        for(int i=0; i<N; i++) {
+            lev[i] = 0;
+            for(int j=frptr[i]; j<dptr[i]; j++) {
+                if(lev[i] < lev[fcind[j]]+1) lev[i] = lev[fcind[j]]+1;
+            }
+            if(num_level < lev[i]+1) num_level = lev[i]+1;
+        }
+        level_ptr = utils::SafeCalloc<int>(num_level+1);
+        rows = utils::SafeMalloc<int>(N);
+        for(int i=0; i<N; i++) { level_ptr[lev[i]+1]++; }
+        for(int l=0; l<num_level; l++) { level_ptr[l+1] += level_ptr[l]; }
+        for(int i=0; i<N; i++) { rows[level_ptr[lev[i]]] = i; level_ptr[lev[i]]++; }
+        for(int l=num_level; l>0; l--) { level_ptr[l] = level_ptr[l-1]; }
+        level_ptr[0] = 0;
+        free(lev);
+        // "L-DU" layout
+        Split<T>(fval, fcind, frptr, &lval, &lcind, &lrptr, &uval, &ucind, &urptr, nullptr, N, "L-DU", false);
+        dst = utils::SafeMalloc<int>(nnz);
+        for(int i=0; i<N; i++) {
+            for(int j=frptr[i]; j<dptr[i]; j++) { dst[j] = lrptr[i] + j - frptr[i]; }
+            for(int j=dptr[i]; j<frptr[i+1]; j++) { dst[j] = urptr[i] + j - dptr[i]; }
+        }
+        // BCSR layout
+        Csr2Bcsr<T>(lval, lcind, lrptr, &blval, &blcind, &blrptr, N, bnl, bnw);
+        Csr2Bcsr<T>(uval, ucind, urptr, &buval, &bucind, &burptr, N, bnl, bnw);
+        bdst = utils::SafeMalloc<int>(nnz);
+        for(int i=0; i<N; i++) {
+            int bi = i / bnl;
+            int b = blrptr[bi];
+            for(int j=frptr[i]; j<dptr[i]; j++) {
+                while(blcind[b] != fcind[j]/bnw) b++;
+                bdst[j] = b*bnl*bnw + (fcind[j]%bnw)*bnl + i%bnl;
+            }
+            b = burptr[bi];
+            for(int j=dptr[i]; j<frptr[i+1]; j++) {
+                while(bucind[b] != fcind[j]/bnw) b++;
+                bdst[j] = b*bnl*bnw + (fcind[j]%bnw)*bnl + i%bnl;
+            }
+        }
+        Refactor(val);
+    }
+    /**
+     * @brief Destructor.
+     * @details Free all memories.
+     */
+    ~IluFactor() {
+        free(fval); free(fcind); free(frptr);
+        free(dptr); free(arptr); free(amap); free(dst); free(bdst);
+        free(level_ptr); free(rows);
+        free(lval); free(lcind); free(lrptr);
+        free(uval); free(ucind); free(urptr);
+        free(blval); free(blcind); free(blrptr);
+        free(buval); free(bucind); free(burptr);
+    }
+    /**
+     * @brief Compute the factors for new values of A.
+     * @details The pattern of A must be the one given to the constructor.
+     * Breakdowns are handled by restarting with a larger diagonal shift, as
+     * in Ilup.
+     * @param val val array of the CSR storage format.
+     * @return The shift used (0 if none was needed).
+     */
+    T Refactor(T *val) {
+        shift = 0;
+        for(int it=0; Numeric(val) > 0; it++) {
+            if(it == 30) {
+                printf("Error: IluFactor, breakdown with shift %e\n", (double)shift);
+                exit(1);
+            }
+            shift = (shift == 0) ? (T)1e-3 : 2*shift;
+        }
+        #pragma omp parallel for
+        for(int i=0; i<N; i++) {
+            for(int j=frptr[i]; j<dptr[i]; j++) {
+                lval[dst[j]] = fval[j];
+                blval[bdst[j]] = fval[j];
+            }
+            T d = 1 / fval[dptr[i]];
+            uval[dst[dptr[i]]] = d;
+            buval[bdst[dptr[i]]] = d;
+            for(int j=dptr[i]+1; j<frptr[i+1]; j++) {
+                uval[dst[j]] = fval[j];
+                buval[bdst[j]] = fval[j];
+            }
+        }
+        return shift;
+    }
+    /**
+     * @brief Get the diagonal shift used by the last factorization.
+     * @return The shift.
+     */
+    T GetShift() { return shift; }
+private:
+    //! The diagonal shift used by the last factorization.
+    T shift;
+    /**
+     * @brief Compute fval with the current shift (see IluNumeric).
+     * @param val val array of the CSR storage format.
+     * @return The number of bad pivots.
+     */
+    int Numeric(T *val) {
+        T tiny = std::sqrt(std::numeric_limits<T>::epsilon());
+        int bad = 0;
+        #pragma omp parallel reduction(+:bad)
+        {
+            int *pos = utils::SafeMalloc<int>(N);
+            for(int i=0; i<N; i++) { pos[i] = -1; }
+            for(int l=0; l<num_level; l++) {
+                #pragma omp for
+                for(int r=level_ptr[l]; r<level_ptr[l+1]; r++) {
+                    int i = rows[r];
+                    for(int j=frptr[i]; j<frptr[i+1]; j++) {
+                        pos[fcind[j]] = j;
+                        fval[j] = 0;
+                    }
+                    T rmax = 0;
+                    for(int j=arptr[i]; j<arptr[i+1]; j++) {
+                        fval[amap[j]] = val[j];
+                        if(rmax < std::abs(val[j])) rmax = std::abs(val[j]);
+                    }
+                    if(shift != 0) fval[dptr[i]] += (fval[dptr[i]] < 0) ? -shift*rmax : shift*rmax;
+                    for(int j=frptr[i]; j<dptr[i]; j++) {
+                        int k = fcind[j];
+                        fval[j] /= fval[dptr[k]];
+                        T pivot = fval[j];
+                        for(int m=dptr[k]+1; m<frptr[k+1]; m++) {
+                            if(pos[fcind[m]] != -1) fval[pos[fcind[m]]] -= pivot * fval[m];
+                        }
+                    }
+                    if(!(std::abs(fval[dptr[i]]) > tiny*rmax)) bad++;
+                    for(int j=frptr[i]; j<frptr[i+1]; j++) { pos[fcind[j]] = -1; }
+                }
+            }
+            free(pos);
+        }
+        return bad;
+    }
+};
+
+} // namespace matrix
+
+} // namespace senk
+
+#endif
@@ -1,12 +1,16 @@
 /**
  * @file senk_gcr.hpp
- * @brief The GCR solvers are defined.
+ * @brief The GCR and ORTHOMIN solvers are defined.
  * @author Kengo Suzuki
  * @date 5/9/2022
  */
 #ifndef SENK_GCR_HPP
 #define SENK_GCR_HPP
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
 #include "senk_sparse.hpp"
 #include "senk_blas1.hpp"
 
@@ -37,38 +41,44 @@ void Gcrm(
     T *p      = new T[N*(m+1)];
     T *Ap     = new T[N*(m+1)];
     T *Ar     = new T[N];
-    T *dot_Ap = new T[m+1];
-    T alpha, beta, nrm_r;
-    
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, r, N);
-        blas1::Axpby<T>(1, b, -1, r, N);
-        blas1::Copy<T>(r, &p[0], N);
-        nrm_r = blas1::Nrm2<T>(r, N);
-        printf("%d %e\n", i*m, nrm_r/nrm_b);
-        if(nrm_r < nrm_b * epsilon) break;
-        sparse::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
-        for(int j=0; j<m; j++) {
-            dot_Ap[j] = blas1::Dot<T>(&Ap[j*N], &Ap[j*N], N);
-            alpha = blas1::Dot<T>(&Ap[j*N], r, N) / dot_Ap[j];
-            blas1::Axpy<T>(alpha, &p[j*N], x, N);
-            blas1::Axpy<T>(-alpha, &Ap[j*N], r, N);
-            sparse::SpmvCsr<T>(val, cind, rptr, r, Ar, N);
-            beta = -blas1::Dot<T>(&Ap[0], Ar, N) / dot_Ap[0];
-            blas1::Axpyz<T>(beta, &p[0], r, &p[(j+1)*N], N);
-            blas1::Axpyz<T>(beta, &Ap[0], Ar, &Ap[(j+1)*N], N);
-            for(int k=1; k<=j; k++) {
-                beta = -blas1::Dot<T>(&Ap[k*N], Ar, N) / dot_Ap[k];
-                blas1::Axpy<T>(beta, &p[k*N], &p[(j+1)*N], N);
-                blas1::Axpy<T>(beta, &Ap[k*N], &Ap[(j+1)*N], N);
+    T *red    = new T[helper::MaxThreads()*(m+1)];
+
+    #pragma omp parallel
+    {
+        T *dot_Ap = new T[m+1];
+        T *beta   = new T[m+1];
+        T alpha, nrm_r;
+        T dots[2];
+
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+            blas1::orphan::Axpby<T>(1, b, -1, r, N);
+            blas1::orphan::Copy<T>(r, &p[0], N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            #pragma omp master
+            printf("%d %e\n", i*m, nrm_r/nrm_b);
+            if(nrm_r < nrm_b * epsilon) break;
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
+            for(int j=0; j<m; j++) {
+                blas1::orphan::DotPair<T>(&Ap[j*N], &Ap[j*N], r, dots, red, N);
+                dot_Ap[j] = dots[0];
+                alpha = dots[1] / dot_Ap[j];
+                blas1::orphan::AxpyPair<T>(alpha, &p[j*N], x, -alpha, &Ap[j*N], r, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, r, Ar, N);
+                blas1::orphan::Mdot<T>(Ap, Ar, beta, red, j+1, N);
+                for(int k=0; k<=j; k++) { beta[k] = -beta[k] / dot_Ap[k]; }
+                blas1::orphan::Maxpyz<T>(p, beta, r, &p[(j+1)*N], j+1, N);
+                blas1::orphan::Maxpyz<T>(Ap, beta, Ar, &Ap[(j+1)*N], j+1, N);
             }
         }
+        delete[] dot_Ap;
+        delete[] beta;
     }
     delete[] r;
     delete[] p;
     delete[] Ap;
     delete[] Ar;
-    delete[] dot_Ap;
+    delete[] red;
 }
 /**
  * @brief The ILU preconditioned GCR(m) solver.
@@ -103,42 +113,48 @@ void IluGcrm(
     T *p      = new T[N*(m+1)];
     T *Ap     = new T[N*(m+1)];
     T *AKr    = new T[N];
-    T *dot_Ap = new T[m+1];
-    T alpha, beta, nrm_r;
-    
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, r, N);
-        blas1::Axpby<T>(1, b, -1, r, N);
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, r, &p[0], N);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, &p[0], &p[0], N);
-        nrm_r = blas1::Nrm2<T>(r, N);
-        printf("%d %e\n", i*m, nrm_r/nrm_b);
-        if(nrm_r < nrm_b * epsilon) break;
-        sparse::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
-        for(int j=0; j<m; j++) {
-            dot_Ap[j] = blas1::Dot<T>(&Ap[j*N], &Ap[j*N], N);
-            alpha = blas1::Dot<T>(&Ap[j*N], r, N) / dot_Ap[j];
-            blas1::Axpy<T>(alpha, &p[j*N], x, N);
-            blas1::Axpy<T>(-alpha, &Ap[j*N], r, N);
-            sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, r, Kr, N);
-            sparse::SptrsvCsr_u<T>(uval, ucind, urptr, Kr, Kr, N);
-            sparse::SpmvCsr<T>(val, cind, rptr, Kr, AKr, N);
-            beta = -blas1::Dot<T>(&Ap[0], AKr, N) / dot_Ap[0];
-            blas1::Axpyz<T>(beta, &p[0], Kr, &p[(j+1)*N], N);
-            blas1::Axpyz<T>(beta, &Ap[0], AKr, &Ap[(j+1)*N], N);
-            for(int k=1; k<=j; k++) {
-                beta = -blas1::Dot<T>(&Ap[k*N], AKr, N) / dot_Ap[k];
-                blas1::Axpy<T>(beta, &p[k*N], &p[(j+1)*N], N);
-                blas1::Axpy<T>(beta, &Ap[k*N], &Ap[(j+1)*N], N);
+    T *red    = new T[helper::MaxThreads()*(m+1)];
+
+    #pragma omp parallel
+    {
+        T *dot_Ap = new T[m+1];
+        T *beta   = new T[m+1];
+        T alpha, nrm_r;
+        T dots[2];
+
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+            blas1::orphan::Axpby<T>(1, b, -1, r, N);
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, r, &p[0], N);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, &p[0], &p[0], N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            #pragma omp master
+            printf("%d %e\n", i*m, nrm_r/nrm_b);
+            if(nrm_r < nrm_b * epsilon) break;
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
+            for(int j=0; j<m; j++) {
+                blas1::orphan::DotPair<T>(&Ap[j*N], &Ap[j*N], r, dots, red, N);
+                dot_Ap[j] = dots[0];
+                alpha = dots[1] / dot_Ap[j];
+                blas1::orphan::AxpyPair<T>(alpha, &p[j*N], x, -alpha, &Ap[j*N], r, N);
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, r, Kr, N);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, Kr, Kr, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kr, AKr, N);
+                blas1::orphan::Mdot<T>(Ap, AKr, beta, red, j+1, N);
+                for(int k=0; k<=j; k++) { beta[k] = -beta[k] / dot_Ap[k]; }
+                blas1::orphan::Maxpyz<T>(p, beta, Kr, &p[(j+1)*N], j+1, N);
+                blas1::orphan::Maxpyz<T>(Ap, beta, AKr, &Ap[(j+1)*N], j+1, N);
             }
         }
+        delete[] dot_Ap;
+        delete[] beta;
     }
     delete[] r;
     delete[] Kr;
     delete[] p;
     delete[] Ap;
     delete[] AKr;
-    delete[] dot_Ap;
+    delete[] red;
 }
 /**
  * @brief The ILUB preconditioned GCR(m) solver.
@@ -173,42 +189,429 @@ void IlubGcrm(
     T *p      = new T[N*(m+1)];
     T *Ap     = new T[N*(m+1)];
     T *AKr    = new T[N];
-    T *dot_Ap = new T[m+1];
-    T alpha, beta, nrm_r;
-    
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, r, N);
-        blas1::Axpby<T>(1, b, -1, r, N);
-        sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, &p[0], N);
-        sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, &p[0], &p[0], N);
-        nrm_r = blas1::Nrm2<T>(r, N);
-        printf("%d %e\n", i*m, nrm_r/nrm_b);
-        if(nrm_r < nrm_b * epsilon) break;
-        sparse::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
-        for(int j=0; j<m; j++) {
-            dot_Ap[j] = blas1::Dot<T>(&Ap[j*N], &Ap[j*N], N);
-            alpha = blas1::Dot<T>(&Ap[j*N], r, N) / dot_Ap[j];
-            blas1::Axpy<T>(alpha, &p[j*N], x, N);
-            blas1::Axpy<T>(-alpha, &Ap[j*N], r, N);
-            sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, Kr, N);
-            sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Kr, Kr, N);
-            sparse::SpmvCsr<T>(val, cind, rptr, Kr, AKr, N);
-            beta = -blas1::Dot<T>(&Ap[0], AKr, N) / dot_Ap[0];
-            blas1::Axpyz<T>(beta, &p[0], Kr, &p[(j+1)*N], N);
-            blas1::Axpyz<T>(beta, &Ap[0], AKr, &Ap[(j+1)*N], N);
-            for(int k=1; k<=j; k++) {
-                beta = -blas1::Dot<T>(&Ap[k*N], AKr, N) / dot_Ap[k];
-                blas1::Axpy<T>(beta, &p[k*N], &p[(j+1)*N], N);
-                blas1::Axpy<T>(beta, &Ap[k*N], &Ap[(j+1)*N], N);
+    T *red    = new T[helper::MaxThreads()*(m+1)];
+
+    #pragma omp parallel
+    {
+        T *dot_Ap = new T[m+1];
+        T *beta   = new T[m+1];
+        T alpha, nrm_r;
+        T dots[2];
+
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+            blas1::orphan::Axpby<T>(1, b, -1, r, N);
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, &p[0], N);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, &p[0], &p[0], N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            #pragma omp master
+            printf("%d %e\n", i*m, nrm_r/nrm_b);
+            if(nrm_r < nrm_b * epsilon) break;
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
+            for(int j=0; j<m; j++) {
+                blas1::orphan::DotPair<T>(&Ap[j*N], &Ap[j*N], r, dots, red, N);
+                dot_Ap[j] = dots[0];
+                alpha = dots[1] / dot_Ap[j];
+                blas1::orphan::AxpyPair<T>(alpha, &p[j*N], x, -alpha, &Ap[j*N], r, N);
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, Kr, N);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Kr, Kr, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kr, AKr, N);
+                blas1::orphan::Mdot<T>(Ap, AKr, beta, red, j+1, N);
+                for(int k=0; k<=j; k++) { beta[k] = -beta[k] / dot_Ap[k]; }
+                blas1::orphan::Maxpyz<T>(p, beta, Kr, &p[(j+1)*N], j+1, N);
+                blas1::orphan::Maxpyz<T>(Ap, beta, AKr, &Ap[(j+1)*N], j+1, N);
+            }
+        }
+        delete[] dot_Ap;
+        delete[] beta;
+    }
+    delete[] r;
+    delete[] Kr;
+    delete[] p;
+    delete[] Ap;
+    delete[] AKr;
+    delete[] red;
+}
+
+/**
+ * @brief The Non-preconditioned ORTHOMIN(k) solver, i.e. GCR truncated to the last k directions.
+ * @details Each new direction is A^T A-orthogonalized only against the last k
+ * directions, so p and Ap are kept in rings of k+1 vectors. The method is
+ * restarted from the true residual when the last k iterations reduce the
+ * residual at less than a quarter of the average rate since the previous restart.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations.
+ * @param k The number of previous directions kept (at least 1).
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void Orthomin(
+    T *val, int *cind, int *rptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int k, int N, T epsilon)
+{
+    if(k < 1) {
+        printf("Error: Orthomin, k must be at least 1\n");
+        exit(1);
+    }
+    T *r      = new T[N];
+    T *p      = new T[N*(k+1)];
+    T *Ap     = new T[N*(k+1)];
+    T *Ar     = new T[N];
+    T *red    = new T[helper::MaxThreads()*(k+1)];
+
+    #pragma omp parallel
+    {
+        T *dot_Ap = new T[k+1];
+        T *beta   = new T[k+1];
+        T alpha, nrm_r = nrm_b, nrm_s, nrm_w;
+        T dots[2];
+        int iter;
+        int s = 0, cnt = 0, its = 0;
+        int restart = 1;
+        int flag = 0;
+
+        for(iter=0; iter<max_iter; iter++) {
+            if(restart) {
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+                blas1::orphan::Axpby<T>(1, b, -1, r, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                if(nrm_r < epsilon * nrm_b) {
+                    flag = 1;
+                    break;
+                }
+                blas1::orphan::Copy<T>(r, &p[0], N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
+                nrm_s = nrm_r;
+                nrm_w = nrm_r;
+                s = 0;
+                cnt = 1;
+                its = 0;
+                restart = 0;
+            }
+            blas1::orphan::DotPair<T>(&Ap[s*N], &Ap[s*N], r, dots, red, N);
+            dot_Ap[s] = dots[0];
+            alpha = dots[1] / dot_Ap[s];
+            blas1::orphan::AxpyPair<T>(alpha, &p[s*N], x, -alpha, &Ap[s*N], r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            its++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter+1, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                iter++;
+                flag = 1;
+                break;
+            }
+            if(its % k == 0) {
+                // Restart when the last k iterations are less than a quarter as fast as the average
+                if(its >= 2*k && std::log(nrm_r/nrm_w) > 0.25 * k / its * std::log(nrm_r/nrm_s)) {
+                    restart = 1;
+                }
+                nrm_w = nrm_r;
+                if(restart) continue;
+            }
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, r, Ar, N);
+            // The new direction overwrites the oldest one once the ring is full
+            int d = (s+1) % (k+1);
+            int n = (cnt < k+1) ? cnt : k+1;
+            blas1::orphan::Mdot<T>(Ap, Ar, beta, red, n, N);
+            for(int q=0; q<n; q++) { beta[q] = -beta[q] / dot_Ap[q]; }
+            if(cnt == k+1) beta[d] = 0;
+            blas1::orphan::Maxpyz<T>(p, beta, r, &p[d*N], n, N);
+            blas1::orphan::Maxpyz<T>(Ap, beta, Ar, &Ap[d*N], n, N);
+            s = d;
+            if(cnt < k+1) cnt++;
+        }
+        if(flag) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] dot_Ap;
+        delete[] beta;
+    }
+    delete[] r;
+    delete[] p;
+    delete[] Ap;
+    delete[] Ar;
+    delete[] red;
+}
+/**
+ * @brief The ILU preconditioned ORTHOMIN(k) solver.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param lval Same as val, but for the matrix L.
+ * @param lcind Same as cind, but for the matrix L.
+ * @param lrptr Same as rptr, but for the matrix L.
+ * @param uval Same as val, but for the matrix U.
+ * @param ucind Same as cind, but for the matrix U.
+ * @param urptr Same as rptr, but for the matrix U.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations.
+ * @param k The number of previous directions kept (at least 1).
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void IluOrthomin(
+    T *val, int *cind, int *rptr,
+    T *lval, int *lcind, int *lrptr,
+    T *uval, int *ucind, int *urptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int k, int N, T epsilon)
+{
+    if(k < 1) {
+        printf("Error: IluOrthomin, k must be at least 1\n");
+        exit(1);
+    }
+    T *r      = new T[N];
+    T *Kr     = new T[N];
+    T *p      = new T[N*(k+1)];
+    T *Ap     = new T[N*(k+1)];
+    T *AKr    = new T[N];
+    T *red    = new T[helper::MaxThreads()*(k+1)];
+
+    #pragma omp parallel
+    {
+        T *dot_Ap = new T[k+1];
+        T *beta   = new T[k+1];
+        T alpha, nrm_r = nrm_b, nrm_s, nrm_w;
+        T dots[2];
+        int iter;
+        int s = 0, cnt = 0, its = 0;
+        int restart = 1;
+        int flag = 0;
+
+        for(iter=0; iter<max_iter; iter++) {
+            if(restart) {
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+                blas1::orphan::Axpby<T>(1, b, -1, r, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                if(nrm_r < epsilon * nrm_b) {
+                    flag = 1;
+                    break;
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, r, &p[0], N);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, &p[0], &p[0], N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
+                nrm_s = nrm_r;
+                nrm_w = nrm_r;
+                s = 0;
+                cnt = 1;
+                its = 0;
+                restart = 0;
+            }
+            blas1::orphan::DotPair<T>(&Ap[s*N], &Ap[s*N], r, dots, red, N);
+            dot_Ap[s] = dots[0];
+            alpha = dots[1] / dot_Ap[s];
+            blas1::orphan::AxpyPair<T>(alpha, &p[s*N], x, -alpha, &Ap[s*N], r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            its++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter+1, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                iter++;
+                flag = 1;
+                break;
+            }
+            if(its % k == 0) {
+                // Restart when the last k iterations are less than a quarter as fast as the average
+                if(its >= 2*k && std::log(nrm_r/nrm_w) > 0.25 * k / its * std::log(nrm_r/nrm_s)) {
+                    restart = 1;
+                }
+                nrm_w = nrm_r;
+                if(restart) continue;
+            }
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, r, Kr, N);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, Kr, Kr, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kr, AKr, N);
+            // The new direction overwrites the oldest one once the ring is full
+            int d = (s+1) % (k+1);
+            int n = (cnt < k+1) ? cnt : k+1;
+            blas1::orphan::Mdot<T>(Ap, AKr, beta, red, n, N);
+            for(int q=0; q<n; q++) { beta[q] = -beta[q] / dot_Ap[q]; }
+            if(cnt == k+1) beta[d] = 0;
+            blas1::orphan::Maxpyz<T>(p, beta, Kr, &p[d*N], n, N);
+            blas1::orphan::Maxpyz<T>(Ap, beta, AKr, &Ap[d*N], n, N);
+            s = d;
+            if(cnt < k+1) cnt++;
+        }
+        if(flag) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] dot_Ap;
+        delete[] beta;
+    }
+    delete[] r;
+    delete[] Kr;
+    delete[] p;
+    delete[] Ap;
+    delete[] AKr;
+    delete[] red;
+}
+/**
+ * @brief The ILUB preconditioned ORTHOMIN(k) solver.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param blval values of L in the BCSR format.
+ * @param blcind colum positions of blocks of L in the BCSR format.
+ * @param blrptr starting positions of row blocks of L in the BCSR format.
+ * @param buval values of U in the BCSR format.
+ * @param bucind colum positions of blocks of U in the BCSR format.
+ * @param burptr starting positions of row blocks of U in the BCSR format.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations.
+ * @param k The number of previous directions kept (at least 1).
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, int bnl, int bnw>
+void IlubOrthomin(
+    T *val, int *cind, int *rptr,
+    T *blval, int *blcind, int *blrptr,
+    T *buval, int *bucind, int *burptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int k, int N, T epsilon)
+{
+    if(k < 1) {
+        printf("Error: IlubOrthomin, k must be at least 1\n");
+        exit(1);
+    }
+    T *r      = new T[N];
+    T *Kr     = new T[N];
+    T *p      = new T[N*(k+1)];
+    T *Ap     = new T[N*(k+1)];
+    T *AKr    = new T[N];
+    T *red    = new T[helper::MaxThreads()*(k+1)];
+
+    #pragma omp parallel
+    {
+        T *dot_Ap = new T[k+1];
+        T *beta   = new T[k+1];
+        T alpha, nrm_r = nrm_b, nrm_s, nrm_w;
+        T dots[2];
+        int iter;
+        int s = 0, cnt = 0, its = 0;
+        int restart = 1;
+        int flag = 0;
+
+        for(iter=0; iter<max_iter; iter++) {
+            if(restart) {
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+                blas1::orphan::Axpby<T>(1, b, -1, r, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                if(nrm_r < epsilon * nrm_b) {
+                    flag = 1;
+                    break;
+                }
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, &p[0], N);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, &p[0], &p[0], N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &p[0], &Ap[0], N);
+                nrm_s = nrm_r;
+                nrm_w = nrm_r;
+                s = 0;
+                cnt = 1;
+                its = 0;
+                restart = 0;
+            }
+            blas1::orphan::DotPair<T>(&Ap[s*N], &Ap[s*N], r, dots, red, N);
+            dot_Ap[s] = dots[0];
+            alpha = dots[1] / dot_Ap[s];
+            blas1::orphan::AxpyPair<T>(alpha, &p[s*N], x, -alpha, &Ap[s*N], r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            its++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter+1, nrm_r/nrm_b);
+#endif
+            if(nrm_r < epsilon * nrm_b) {
+                iter++;
+                flag = 1;
+                break;
+            }
+            if(its % k == 0) {
+                // Restart when the last k iterations are less than a quarter as fast as the average
+                if(its >= 2*k && std::log(nrm_r/nrm_w) > 0.25 * k / its * std::log(nrm_r/nrm_s)) {
+                    restart = 1;
+                }
+                nrm_w = nrm_r;
+                if(restart) continue;
+            }
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, Kr, N);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, Kr, Kr, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, Kr, AKr, N);
+            // The new direction overwrites the oldest one once the ring is full
+            int d = (s+1) % (k+1);
+            int n = (cnt < k+1) ? cnt : k+1;
+            blas1::orphan::Mdot<T>(Ap, AKr, beta, red, n, N);
+            for(int q=0; q<n; q++) { beta[q] = -beta[q] / dot_Ap[q]; }
+            if(cnt == k+1) beta[d] = 0;
+            blas1::orphan::Maxpyz<T>(p, beta, Kr, &p[d*N], n, N);
+            blas1::orphan::Maxpyz<T>(Ap, beta, AKr, &Ap[d*N], n, N);
+            s = d;
+            if(cnt < k+1) cnt++;
+        }
+        if(flag) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
             }
         }
+        delete[] dot_Ap;
+        delete[] beta;
     }
     delete[] r;
     delete[] Kr;
     delete[] p;
     delete[] Ap;
     delete[] AKr;
-    delete[] dot_Ap;
+    delete[] red;
 }
 
 } // namespace solver
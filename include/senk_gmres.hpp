@@ -19,6 +19,7 @@ namespace solver {
 /**
  * @brief The Non-preconditioned GMRES(m) solver.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -30,68 +31,83 @@ namespace solver {
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T>
+template <typename T, typename TV = T>
 void Gmresm(
     T *val, int *cind, int *rptr,
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        senk::blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        senk::blas1::Scal<T>(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SpmvCsr<T>(val, cind, rptr, &V[j*N], &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
-            }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
-            }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, w, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 1, x, j, N);
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        for(int k=0; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], x, N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
+    delete[] red;
 }
 
 /**
@@ -99,6 +115,7 @@ void Gmresm(
  * @tparam T The type of a coefficient matrix and vectors.
  * @tparam bnl The number of rows of the block.
  * @tparam bnw The number of columns of the block.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param bval val array of the BCSR storage format.
  * @param bcind column index array of the BCSR storage format.
  * @param brptr row pointer array of the BCSR storage format.
@@ -110,73 +127,89 @@ void Gmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T, int bnl, int bnw>
+template <typename T, int bnl, int bnw, typename TV = T>
 void Gmresm(
     T *bval, int *bcind, int *brptr,
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, x, &V[0], N);
-        senk::blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        senk::blas1::Scal<T>(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, &V[j*N], &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
-            }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
-            }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, w, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 1, x, j, N);
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        for(int k=0; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], x, N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
+    delete[] red;
 }
 
 /**
  * @brief The ILU preconditioned GMRES(m) solver.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -194,7 +227,7 @@ void Gmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T>
+template <typename T, typename TV = T>
 void IluGmresm(
     T *val, int *cind, int *rptr,
     T *lval, int *lcind, int *lrptr,
@@ -202,75 +235,90 @@ void IluGmresm(
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-    T *t = new T[N];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        blas1::Scal<T>(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[j*N], t, N);
-            sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
-            sparse::SpmvCsr<T>(val, cind, rptr, t, &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
-            }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
-            }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, w, t, N);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, W, t, N);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        blas1::Scal<T>(y[0], &V[0], N);
-        for(int k=1; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], &V[0], N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[0], t, N);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
-        blas1::Axpy<T>(1, t, x, N);
-
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
     delete[] t;
+    delete[] red;
 }
 /**
  * @brief The ILU preconditioned GMRES(m) solver parallelized by AMC ordering.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -290,7 +338,7 @@ void IluGmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T>
+template <typename T, typename TV = T>
 void AmcIluGmresm(
     T *val, int *cind, int *rptr,
     T *lval, int *lcind, int *lrptr,
@@ -299,75 +347,90 @@ void AmcIluGmresm(
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-    T *t = new T[N];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        blas1::Scal<T>(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[j*N], t, N, cptr, cnum);
-            sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum);
-            sparse::SpmvCsr<T>(val, cind, rptr, t, &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
-            }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
-            }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, w, t, N, cptr, cnum);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, W, t, N, cptr, cnum);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        blas1::Scal<T>(y[0], &V[0], N);
-        for(int k=1; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], &V[0], N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[0], t, N, cptr, cnum);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum);
-        blas1::Axpy<T>(1, t, x, N);
-
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
     delete[] t;
+    delete[] red;
 }
 /**
  * @brief The ILU preconditioned GMRES(m) solver parallelized by ABMC ordering.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -388,7 +451,7 @@ void AmcIluGmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T>
+template <typename T, typename TV = T>
 void AbmcIluGmresm(
     T *val, int *cind, int *rptr,
     T *lval, int *lcind, int *lrptr,
@@ -397,75 +460,90 @@ void AbmcIluGmresm(
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-    T *t = new T[N];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        blas1::Scal<T>(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[j*N], t, N, cptr, cnum, bsize);
-            sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
-            sparse::SpmvCsr<T>(val, cind, rptr, t, &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
-            }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
-            }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, w, t, N, cptr, cnum, bsize);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, W, t, N, cptr, cnum, bsize);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        blas1::Scal<T>(y[0], &V[0], N);
-        for(int k=1; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], &V[0], N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[0], t, N, cptr, cnum, bsize);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
-        blas1::Axpy<T>(1, t, x, N);
-
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
     delete[] t;
+    delete[] red;
 }
 /**
  * @brief The ILU preconditioned GMRES(m) solver parallelized by the block Jacobi method.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -484,7 +562,7 @@ void AbmcIluGmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T>
+template <typename T, typename TV = T>
 void BjIluGmresm(
     T *val, int *cind, int *rptr,
     T *lval, int *lcind, int *lrptr,
@@ -493,75 +571,90 @@ void BjIluGmresm(
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-    T *t = new T[N];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        blas1::Scal<T>(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[j*N], t, N, bnum);
-            sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, bnum);
-            sparse::SpmvCsr<T>(val, cind, rptr, t, &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
-            }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
-            }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, w, t, N, bnum);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, bnum);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, W, t, N, bnum);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, bnum);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        blas1::Scal<T>(y[0], &V[0], N);
-        for(int k=1; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], &V[0], N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        sparse::SptrsvCsr_l<T>(lval, lcind, lrptr, &V[0], t, N, bnum);
-        sparse::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, bnum);
-        blas1::Axpy<T>(1, t, x, N);
-
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
     delete[] t;
+    delete[] red;
 }
 /**
  * @brief The ILUB preconditioned GMRES(m) solver.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -579,7 +672,7 @@ void BjIluGmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T, int bnl, int bnw>
+template <typename T, int bnl, int bnw, typename TV = T>
 void IlubGmresm(
     T *val, int *cind, int *rptr,
     T *blval, int *blcind, int *blrptr,
@@ -587,75 +680,201 @@ void IlubGmresm(
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-    T *t = new T[N];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        blas1::Scal(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, &V[j*N], t, N);
-            sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
-            sparse::SpmvCsr<T>(val, cind, rptr, t, &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, w, t, N);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, W, t, N);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
             }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] red;
+}
+/**
+ * @brief The block ILU (BILU) preconditioned GMRES(m) solver.
+ * @details The factors are given by matrix::Bilup.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam bs The number of rows/columns of the block.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param blval values of L in the BCSR format.
+ * @param blcind colum positions of blocks of L in the BCSR format.
+ * @param blrptr starting positions of row blocks of L in the BCSR format.
+ * @param buval values of U, whose diagonal blocks are inverted, in the BCSR format.
+ * @param bucind colum positions of blocks of U in the BCSR format.
+ * @param burptr starting positions of row blocks of U in the BCSR format.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, int bs, typename TV = T>
+void BiluGmresm(
+    T *val, int *cind, int *rptr,
+    T *blval, int *blcind, int *blrptr,
+    T *buval, int *bucind, int *burptr,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvBcsr_l<T, bs, bs>(blval, blcind, blrptr, w, t, N);
+                sparse::orphan::SptrsvBcsr_bu<T, bs>(buval, bucind, burptr, t, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvBcsr_l<T, bs, bs>(blval, blcind, blrptr, W, t, N);
+            sparse::orphan::SptrsvBcsr_bu<T, bs>(buval, bucind, burptr, t, t, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        blas1::Scal<T>(y[0], &V[0], N);
-        for(int k=1; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], &V[0], N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, &V[0], t, N);
-        sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
-        blas1::Axpy<T>(1, t, x, N);
-
-        if(flag == 1) break;
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
-    }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
     delete[] t;
+    delete[] red;
 }
 /**
  * @brief The ILUB preconditioned GMRES(m) solver parallelized by ABMC ordering.
  * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
  * @param val val array of the CSR storage format.
  * @param cind column index array of the CSR storage format.
  * @param rptr row pointer array of the CSR storage format.
@@ -676,7 +895,7 @@ void IlubGmresm(
  * @param N The size of the matrix and the vectors.
  * @param epsilon The convergence criterion.
  */
-template <typename T, int bnl, int bnw>
+template <typename T, int bnl, int bnw, typename TV = T>
 void AbmcIlubGmresm(
     T *val, int *cind, int *rptr,
     T *blval, int *blcind, int *blrptr,
@@ -685,71 +904,199 @@ void AbmcIlubGmresm(
     T *b, T *x, T nrm_b,
     int outer, int m, int N, T epsilon)
 {
-    T *c = new T[m];
-    T *s = new T[m];
-    T *e = new T[m+1];
-    T *H = new T[(m+1)*m];
-    T *V = new T[N*(m+1)];
-    T *y = new T[m];
-    T *t = new T[N];
-
-    int flag = 0;
-    for(int i=0; i<outer; i++) {
-        sparse::SpmvCsr<T>(val, cind, rptr, x, &V[0], N);
-        blas1::Axpby<T>(1, b, -1, &V[0], N);
-        e[0] = blas1::Nrm2<T>(&V[0], N);
-        blas1::Scal(1/e[0], &V[0], N);
-        int j;
-        for(j=0; j<m; j++) {
-            sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, &V[j*N], t, N, cptr, cnum, bsize);
-            sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N, cptr, cnum, bsize);
-            sparse::SpmvCsr<T>(val, cind, rptr, t, &V[(j+1)*N], N);
-            for(int k=0; k<=j; k++) {
-                H[j*(m+1)+k] = blas1::Dot<T>(&V[k*N], &V[(j+1)*N], N);
-                blas1::Axpy<T>(-H[j*(m+1)+k], &V[k*N], &V[(j+1)*N], N);
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, w, t, N, cptr, cnum, bsize);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N, cptr, cnum, bsize);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
-            H[j*(m+1)+j+1] = blas1::Nrm2<T>(&V[(j+1)*N], N);
-            blas1::Scal<T>(1/H[j*(m+1)+j+1], &V[(j+1)*N], N);
-            for(int k=0; k<j; k++) {
-                blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, W, t, N, cptr, cnum, bsize);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N, cptr, cnum, bsize);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
             }
-            H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
-            H[j*(m+1)+j+1] = 0;
-            e[j+1] = s[j] * e[j];
-            e[j] = c[j] * e[j];
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] red;
+}
+/**
+ * @brief The ILUB preconditioned GMRES(m) solver parallelized by hierarchical ABMC ordering.
+ * @details The matrix is ordered by graph::GetHABMCPermutation.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param blval values of L in the BCSR format.
+ * @param blcind colum positions of blocks of L in the BCSR format.
+ * @param blrptr starting positions of row blocks of L in the BCSR format.
+ * @param buval values of U in the BCSR format.
+ * @param bucind colum positions of blocks of U in the BCSR format.
+ * @param burptr starting positions of row blocks of U in the BCSR format.
+ * @param cptr The starting super-block of each color is stored.
+ * @param cnum The number of colors.
+ * @param sptr The starting row of each super-block is stored.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, int bnl, int bnw, typename TV = T>
+void HabmcIlubGmresm(
+    T *val, int *cind, int *rptr,
+    T *blval, int *blcind, int *blrptr,
+    T *buval, int *bucind, int *burptr,
+    int *cptr, int cnum, int *sptr,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, w, t, N, cptr, cnum, sptr);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N, cptr, cnum, sptr);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
 #if PRINT_RES
-            printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
 #endif
-            if(std::abs(e[j+1]) <= nrm_b*epsilon) {
-                printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
-                printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
-                j++;
-                flag = 1;
-                break;
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
             }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, W, t, N, cptr, cnum, sptr);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N, cptr, cnum, sptr);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
         }
-        blas2::Trsv<T>(H, e, y, m+1, j);
-        blas1::Scal<T>(y[0], &V[0], N);
-        for(int k=1; k<j; k++) {
-            blas1::Axpy<T>(y[k], &V[k*N], &V[0], N);
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
         }
-        sparse::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, &V[0], t, N, cptr, cnum, bsize);
-        sparse::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N, cptr, cnum, bsize);
-        blas1::Axpy<T>(1, t, x, N);
-
-        if(flag == 1) break;
-    }
-    if(!flag) {
-        printf("# iter %d\n", outer*m);
-        printf("# res : Check by using senk::test\n");
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
     }
-    delete[] c;
-    delete[] s;
-    delete[] e;
-    delete[] H;
     delete[] V;
-    delete[] y;
+    delete[] W;
     delete[] t;
+    delete[] red;
 }
 
 } // namespace solver
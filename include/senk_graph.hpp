@@ -7,7 +7,12 @@
 #ifndef SENK_GRAPH_HPP
 #define SENK_GRAPH_HPP
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include "senk_utils.hpp"
+#include "senk_helper.hpp"
 
 namespace senk {
 /**
@@ -32,14 +37,14 @@ static void SimpleBlocking( // Simple Blocking
     *block = utils::SafeMalloc<int>(N);
     for(int i=0; i<N; i++) { (*block)[i] = i; }
     
-    *b_rptr = utils::SafeMalloc<int>(N/bsize+1);
+    *b_rptr = utils::SafeMalloc<int>((N+bsize-1)/bsize+1);
     *b_cind = utils::SafeMalloc<int>(rptr[N]); // At most rptr[N]
     int cnt = 0;
     (*b_rptr)[0] = 0;
     int *ptr = utils::SafeMalloc<int>(bsize);
     for(int i=0; i<N; i+=bsize) {
-        // Initialize "ptr"
-        for(int j=0; j<bsize; j++) { ptr[j] = rptr[(*block)[i+j]]; }
+        // Initialize "ptr" (the last block may be smaller)
+        for(int j=0; j<bsize; j++) { ptr[j] = (i+j < N) ? rptr[(*block)[i+j]] : -1; }
         while(true) {
             // Find minimum col index
             int min = N;
@@ -108,16 +113,16 @@ static void ConnectedBlocking( // Connected Blocking
             if(qs == qe) { break; }
         }
     }
-    for(int i=0; i<N; i+=bsize) senk::helper::QuickSort<int>(*block, i, i+bsize-1);
+    for(int i=0; i<N; i+=bsize) senk::helper::QuickSort<int>(*block, i, std::min(i+bsize, N)-1);
 
-    *b_rptr = utils::SafeMalloc<int>(N/bsize+1);
+    *b_rptr = utils::SafeMalloc<int>((N+bsize-1)/bsize+1);
     *b_cind = utils::SafeMalloc<int>(rptr[N]); // At most rptr[N]
     int *temp = utils::SafeMalloc<int>(rptr[N]); // At most rptr[N]
     int cnt = 0;
     (*b_rptr)[0] = 0;
     for(int i=0; i<N; i+=bsize) {
         int len = 0;
-        for(int j=0; j<bsize; j++) {
+        for(int j=0; j<bsize && i+j<N; j++) {
             for(int k=rptr[(*block)[i+j]]; k<rptr[(*block)[i+j]+1]; k++) {
                 temp[len] = inv_block[cind[k]]; len++;
             }
@@ -158,53 +163,85 @@ static void GetAdjacency(
         utils::Copy<int>(cind, *am_cind, rptr[N]);
         utils::Copy<int>(rptr, *am_rptr, N+1);
     }else {
+        // Transpose of the pattern with per-thread counts of the columns
+        int nt = helper::MaxThreads();
         int *rind = utils::SafeMalloc<int>(rptr[N]);
         int *cptr = utils::SafeMalloc<int>(N+1);
-        int *len = utils::SafeCalloc<int>(N);
-        for(int i=0; i<N; i++) {
-            for(int j=rptr[i]; j<rptr[i+1]; j++) {
-                len[cind[j]]++;
-            }
-        }
-        cptr[0] = 0;
-        for(int i=0; i<N; i++) {
-            cptr[i+1] = cptr[i] + len[i];
-            len[i] = 0;
-        }
-        for(int i=0; i<N; i++) {
-            for(int j=rptr[i]; j<rptr[i+1]; j++) {
-                rind[cptr[cind[j]]+len[cind[j]]] = i;
-                len[cind[j]]++;
-            }
-        }
-        *am_cind = utils::SafeMalloc<int>(rptr[N]*2);
+        int *len = utils::SafeMalloc<int>(nt*N);
+        int *work = utils::SafeMalloc<int>(nt+1);
         *am_rptr = utils::SafeMalloc<int>(N+1);
+        cptr[0] = 0;
         (*am_rptr)[0] = 0;
-        int cnt = 0;
-        for(int i=0; i<N; i++) {
-            int csr_ptr = rptr[i];
-            int csc_ptr = cptr[i];
-            while(csr_ptr < rptr[i+1] || csc_ptr < cptr[i+1]) {
-                int csr_idx = (csr_ptr < rptr[i+1])? cind[csr_ptr] : N;
-                int csc_idx = (csc_ptr < cptr[i+1])? rind[csc_ptr] : N;
-                if(csr_idx < csc_idx) {
-                    (*am_cind)[cnt] = csr_idx;
-                    csr_ptr++;
-                }else if(csr_idx == csc_idx){
-                    (*am_cind)[cnt] = csr_idx;
-                    csr_ptr++;
-                    csc_ptr++;
-                }else {
-                    (*am_cind)[cnt] = csc_idx;
-                    csc_ptr++;
+        #pragma omp parallel
+        {
+            int tnum = helper::NumThreads();
+            int *cnt = &len[helper::ThreadId()*N];
+            int start, end;
+            helper::ThreadRange(N, &start, &end);
+            for(int i=0; i<N; i++) { cnt[i] = 0; }
+            for(int i=start; i<end; i++) {
+                for(int j=rptr[i]; j<rptr[i+1]; j++) { cnt[cind[j]]++; }
+            }
+            #pragma omp barrier
+            #pragma omp for
+            for(int i=0; i<N; i++) {
+                int sum = 0;
+                for(int t=0; t<tnum; t++) {
+                    int temp = len[t*N+i];
+                    len[t*N+i] = sum;
+                    sum += temp;
+                }
+                cptr[i+1] = sum;
+            }
+            helper::PrefixSum(cptr, N, work);
+            for(int i=start; i<end; i++) {
+                for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                    rind[cptr[cind[j]]+cnt[cind[j]]] = i;
+                    cnt[cind[j]]++;
+                }
+            }
+            // Merge the rows of the matrix and its transpose
+            for(int i=0; i<N; i++) { cnt[i] = -1; }
+            #pragma omp barrier
+            #pragma omp for
+            for(int i=0; i<N; i++) {
+                int num = rptr[i+1] - rptr[i];
+                for(int j=rptr[i]; j<rptr[i+1]; j++) { cnt[cind[j]] = i; }
+                for(int j=cptr[i]; j<cptr[i+1]; j++) {
+                    if(cnt[rind[j]] != i) num++;
+                }
+                (*am_rptr)[i+1] = num;
+            }
+            helper::PrefixSum(*am_rptr, N, work);
+            #pragma omp single
+            *am_cind = utils::SafeMalloc<int>((*am_rptr)[N]);
+            #pragma omp for
+            for(int i=0; i<N; i++) {
+                int csr_ptr = rptr[i];
+                int csc_ptr = cptr[i];
+                int pos = (*am_rptr)[i];
+                while(csr_ptr < rptr[i+1] || csc_ptr < cptr[i+1]) {
+                    int csr_idx = (csr_ptr < rptr[i+1])? cind[csr_ptr] : N;
+                    int csc_idx = (csc_ptr < cptr[i+1])? rind[csc_ptr] : N;
+                    if(csr_idx < csc_idx) {
+                        (*am_cind)[pos] = csr_idx;
+                        csr_ptr++;
+                    }else if(csr_idx == csc_idx){
+                        (*am_cind)[pos] = csr_idx;
+                        csr_ptr++;
+                        csc_ptr++;
+                    }else {
+                        (*am_cind)[pos] = csc_idx;
+                        csc_ptr++;
+                    }
+                    pos++;
                 }
-                cnt++;
             }
-            (*am_rptr)[i+1] = cnt;
         }
         free(rind);
         free(cptr);
         free(len);
+        free(work);
     }
 }
 /**
@@ -218,23 +255,1247 @@ static void GetAdjacency(
 static void Coloring( // Greedy Coloring
     int *cind, int *rptr, int **color, int *num_color, int N)
 {
+    // First fit in the natural order: each node takes the smallest color that
+    // is not used by its neighbors of smaller index. For a symmetric pattern
+    // this is the coloring obtained by sweeping all nodes once per color.
     *color = utils::SafeCalloc<int>(N);
-    int *visit = utils::SafeCalloc<int>(N);
-    int now = 1;
+    int *used = utils::SafeMalloc<int>(N+2);
+    for(int i=0; i<N+2; i++) { used[i] = -1; }
+    *num_color = 0;
+    for(int i=0; i<N; i++) {
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            used[(*color)[cind[j]]] = i;
+        }
+        int c = 1;
+        while(used[c] == i) c++;
+        (*color)[i] = c;
+        if(*num_color < c) *num_color = c;
+    }
+    free(used);
+}
+/**
+ * @brief Coloring an adjacency matrix in parallel by first fit over multicolored chunks.
+ * @details The nodes are cut into chunks of csize consecutive indices and the
+ * graph of the chunks is colored by Coloring. The chunks of a chunk color are
+ * not adjacent, so they are colored by first fit in parallel, chunk color by
+ * chunk color, each node seeing the final colors of all its neighbors that
+ * were colored before it. This is the first fit in a fixed order, so the
+ * result does not depend on the number of threads. The parallelism relies on
+ * the locality of the ordering: when most chunks are adjacent to each other,
+ * the chunk colors are processed almost one chunk at a time.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param color A pointer to an array that maps indices to colors.
+ * @param num_color A variable to receive the number of colors.
+ * @param N The size of a input graph (matrix)
+ * @param csize The number of nodes of a chunk.
+ */
+inline void ParallelColoring(
+    int *cind, int *rptr, int **color, int *num_color, int N, int csize = 1024)
+{
+    int nchunk = (N+csize-1) / csize;
+    // Graph of the chunks
+    int *q_rptr = utils::SafeMalloc<int>(nchunk+1);
+    int *q_cind;
+    q_rptr[0] = 0;
+    #pragma omp parallel
+    {
+        int *mark = utils::SafeMalloc<int>(nchunk);
+        for(int q=0; q<nchunk; q++) { mark[q] = -1; }
+        #pragma omp for
+        for(int q=0; q<nchunk; q++) {
+            int end = (q*csize+csize < N) ? q*csize+csize : N;
+            int cnt = 0;
+            for(int i=q*csize; i<end; i++) {
+                for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                    int c = cind[j] / csize;
+                    if(mark[c] == q) continue;
+                    mark[c] = q;
+                    cnt++;
+                }
+            }
+            q_rptr[q+1] = cnt;
+        }
+        #pragma omp single
+        {
+            for(int q=0; q<nchunk; q++) { q_rptr[q+1] += q_rptr[q]; }
+            q_cind = utils::SafeMalloc<int>(q_rptr[nchunk]);
+        }
+        for(int q=0; q<nchunk; q++) { mark[q] = -1; }
+        #pragma omp for
+        for(int q=0; q<nchunk; q++) {
+            int end = (q*csize+csize < N) ? q*csize+csize : N;
+            int cnt = q_rptr[q];
+            for(int i=q*csize; i<end; i++) {
+                for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                    int c = cind[j] / csize;
+                    if(mark[c] == q) continue;
+                    mark[c] = q;
+                    q_cind[cnt] = c;
+                    cnt++;
+                }
+            }
+        }
+        free(mark);
+    }
+    int *q_color;
+    int q_num_color;
+    Coloring(q_cind, q_rptr, &q_color, &q_num_color, nchunk);
+    // Chunks sorted by color
+    int *q_ptr = utils::SafeCalloc<int>(q_num_color+1);
+    int *q_list = utils::SafeMalloc<int>(nchunk);
+    for(int q=0; q<nchunk; q++) { q_ptr[q_color[q]]++; }
+    for(int k=0; k<q_num_color; k++) { q_ptr[k+1] += q_ptr[k]; }
+    int *pos = utils::SafeMalloc<int>(q_num_color);
+    for(int k=0; k<q_num_color; k++) { pos[k] = q_ptr[k]; }
+    for(int q=0; q<nchunk; q++) {
+        q_list[pos[q_color[q]-1]] = q;
+        pos[q_color[q]-1]++;
+    }
+    free(pos);
+    // First fit
+    int max_deg = 0;
+    #pragma omp parallel for reduction(max:max_deg)
+    for(int i=0; i<N; i++) {
+        if(max_deg < rptr[i+1]-rptr[i]) max_deg = rptr[i+1]-rptr[i];
+    }
+    int *col = utils::SafeCalloc<int>(N);
+    #pragma omp parallel
+    {
+        int *used = utils::SafeMalloc<int>(max_deg+2);
+        for(int c=0; c<max_deg+2; c++) { used[c] = -1; }
+        for(int k=0; k<q_num_color; k++) {
+            #pragma omp for schedule(dynamic)
+            for(int t=q_ptr[k]; t<q_ptr[k+1]; t++) {
+                int q = q_list[t];
+                int end = (q*csize+csize < N) ? q*csize+csize : N;
+                for(int i=q*csize; i<end; i++) {
+                    for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                        used[col[cind[j]]] = i;
+                    }
+                    int c = 1;
+                    while(used[c] == i) c++;
+                    col[i] = c;
+                }
+            }
+        }
+        free(used);
+    }
+    *color = col;
+    *num_color = 0;
+    for(int i=0; i<N; i++) {
+        if(*num_color < col[i]) *num_color = col[i];
+    }
+    free(q_rptr);
+    free(q_cind);
+    free(q_color);
+    free(q_ptr);
+    free(q_list);
+}
+/**
+ * @brief Recolor an adjacency matrix toward colors of equal size.
+ * @details First, the colors smaller than min_size are removed when all their
+ * nodes can be moved to other colors (of at least min_size nodes) that none
+ * of their neighbors have. Then, in the natural order, each node of a color
+ * larger than the mean size is moved to the first color smaller than the
+ * mean that none of its neighbors have. The colors are renumbered from 1
+ * keeping their order.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param color An array that maps indices to colors (1, ..., num_color), which is updated.
+ * @param num_color A variable that holds the number of colors, which is updated.
+ * @param N The size of a input graph (matrix)
+ * @param min_size The minimum size of a color (0 to keep all colors).
+ */
+inline void BalanceColoring(
+    int *cind, int *rptr, int *color, int *num_color, int N, int min_size)
+{
+    int nc = *num_color;
+    int *size = utils::SafeCalloc<int>(nc+1);
+    int *used = utils::SafeMalloc<int>(nc+1);
+    int *ptr  = utils::SafeCalloc<int>(nc+2);
+    int *list = utils::SafeMalloc<int>(N);
+    for(int c=0; c<=nc; c++) { used[c] = -1; }
+    for(int i=0; i<N; i++) { size[color[i]]++; }
+    // Nodes sorted by color
+    for(int c=1; c<=nc; c++) { ptr[c+1] = ptr[c] + size[c]; }
+    for(int i=0; i<N; i++) { list[ptr[color[i]]] = i; ptr[color[i]]++; }
+    for(int c=nc; c>0; c--) { ptr[c] = ptr[c-1]; }
+    ptr[1] = 0;
+    // Removal of the small colors, from the last one
+    for(int c=nc; c>0; c--) {
+        if(size[c] == 0 || size[c] >= min_size) continue;
+        int moved = 0;
+        for(int k=ptr[c]; k<ptr[c+1]; k++) {
+            int i = list[k];
+            for(int j=rptr[i]; j<rptr[i+1]; j++) { used[color[cind[j]]] = i; }
+            int t;
+            for(t=1; t<=nc; t++) {
+                if(t != c && used[t] != i && size[t] >= min_size) break;
+            }
+            if(t > nc) break;
+            color[i] = t;
+            size[t]++;
+            moved++;
+        }
+        if(moved < size[c]) {
+            // Undo: the color cannot be removed.
+            for(int k=ptr[c]; k<ptr[c]+moved; k++) {
+                size[color[list[k]]]--;
+                color[list[k]] = c;
+            }
+        }else {
+            size[c] = 0;
+        }
+    }
+    // Balancing
+    int live = 0;
+    for(int c=1; c<=nc; c++) { if(size[c] > 0) live++; }
+    int gamma = (N + live - 1) / live;
+    for(int i=0; i<N; i++) {
+        int c = color[i];
+        if(size[c] <= gamma) continue;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) { used[color[cind[j]]] = N+i; }
+        for(int t=1; t<=nc; t++) {
+            if(size[t] == 0 || size[t] >= gamma || used[t] == N+i) continue;
+            color[i] = t;
+            size[c]--;
+            size[t]++;
+            break;
+        }
+    }
+    // Renumbering
+    int *map = utils::SafeCalloc<int>(nc+1);
+    *num_color = 0;
+    for(int c=1; c<=nc; c++) {
+        if(size[c] > 0) { (*num_color)++; map[c] = *num_color; }
+    }
+    for(int i=0; i<N; i++) { color[i] = map[color[i]]; }
+    free(size);
+    free(used);
+    free(ptr);
+    free(list);
+    free(map);
+}
+/**
+ * @brief Print the size of each color and the occupancy of the threads.
+ * @details The occupancy of a color is the fraction of the iterations of its
+ * omp for that are filled when its rows (or blocks) are shared statically
+ * among num_threads threads. The rounds are the number of iterations of
+ * a thread summed over the colors.
+ * @param num_color The number of colors.
+ * @param size_color The starting index of each color (num_color+1 entries).
+ * @param num_threads The number of threads.
+ */
+inline void PrintOccupancy(int num_color, int *size_color, int num_threads)
+{
+    long total = 0;
+    long slots = 0;
+    int min = size_color[num_color];
+    int max = 0;
+    printf("# color size occupancy\n");
+    for(int k=0; k<num_color; k++) {
+        int s = size_color[k+1] - size_color[k];
+        long slot = (long)((s + num_threads - 1) / num_threads) * num_threads;
+        printf("# %d %d %.3f\n", k, s, (slot == 0) ? 0.0 : (double)s / slot);
+        total += s;
+        slots += slot;
+        if(min > s) min = s;
+        if(max < s) max = s;
+    }
+    printf("# colors %d, size min %d max %d, occupancy %.3f, rounds %ld (ideal %ld)\n",
+        num_color, min, max, (slots == 0) ? 0.0 : (double)total / slots,
+        slots / num_threads, (total + num_threads - 1) / num_threads);
+}
+/**
+ * @brief Partition a graph into parts of nearly equal size along a breadth-first order.
+ * @details The nodes are numbered in breadth-first order, component by
+ * component, and the order is cut into num_part consecutive pieces. The parts
+ * are compact bands of BFS levels, but they are not guaranteed to be
+ * connected: a piece may span two components or a level that splits into
+ * several pieces of the graph.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param part A pointer to receive the part of each node.
+ * @param N The size of the input graph (matrix)
+ * @param num_part The number of parts.
+ * @param isSym Whether the input matrix is symmetric or not.
+ */
+inline void BfsPartition(
+    int *cind, int *rptr, int **part,
+    int N, int num_part, bool isSym)
+{
+    int *am_cind;
+    int *am_rptr;
+    GetAdjacency(cind, rptr, &am_cind, &am_rptr, N, isSym);
+    *part = utils::SafeMalloc<int>(N);
+    int *queue = utils::SafeMalloc<int>(N);
+    bool *visited = utils::SafeCalloc<bool>(N);
+    int qe = 0;
+    for(int i=0; i<N; i++) {
+        if(visited[i]) continue;
+        int qs = qe;
+        queue[qe] = i; qe++;
+        visited[i] = true;
+        while(qs < qe) {
+            int q = queue[qs]; qs++;
+            for(int j=am_rptr[q]; j<am_rptr[q+1]; j++) {
+                if(visited[am_cind[j]]) continue;
+                visited[am_cind[j]] = true;
+                queue[qe] = am_cind[j]; qe++;
+            }
+        }
+    }
+    for(int k=0; k<N; k++) {
+        (*part)[queue[k]] = (int)((long)k * num_part / N);
+    }
+    free(am_cind);
+    free(am_rptr);
+    free(queue);
+    free(visited);
+}
+/**
+ * @brief A graph with node and edge weights, used by the multilevel partitioner.
+ */
+struct WGraph {
+    //! The number of nodes.
+    int n;
+    //! The row pointer of the adjacency lists, which have no self loops.
+    int *xadj;
+    //! The adjacency lists.
+    int *adj;
+    //! The weight of each edge.
+    int *adjw;
+    //! The weight of each node.
+    int *vw;
+};
+/**
+ * @brief Free the arrays of a weighted graph.
+ * @param g The graph.
+ */
+inline void FreeWGraph(WGraph *g)
+{
+    free(g->xadj);
+    free(g->adj);
+    free(g->adjw);
+    free(g->vw);
+}
+/**
+ * @brief A xorshift generator, so that the partitions are reproducible.
+ * @param seed The state, which is updated.
+ * @return The next random number.
+ */
+inline unsigned int NextRandom(unsigned int *seed)
+{
+    unsigned int x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+/**
+ * @brief A max-heap of nodes keyed by their gains, whose keys can be updated.
+ */
+class GainHeap {
+private:
+    //! The number of nodes in the heap.
+    int size;
+    //! The key at each position.
+    int *key;
+    //! The node at each position.
+    int *node;
+    //! The position of each node (-1 if absent).
+    int *loc;
+    void Exchange(int a, int b) {
+        helper::Swap<int>(&key[a], &key[b]);
+        helper::Swap<int>(&node[a], &node[b]);
+        loc[node[a]] = a;
+        loc[node[b]] = b;
+    }
+    void Up(int i) {
+        while(i > 0 && key[(i-1)/2] < key[i]) {
+            Exchange(i, (i-1)/2);
+            i = (i-1)/2;
+        }
+    }
+    void Down(int i) {
+        while(true) {
+            int m = i;
+            if(2*i+1 < size && key[2*i+1] > key[m]) m = 2*i+1;
+            if(2*i+2 < size && key[2*i+2] > key[m]) m = 2*i+2;
+            if(m == i) break;
+            Exchange(i, m);
+            i = m;
+        }
+    }
+public:
+    /**
+     * @brief Constructor.
+     * @param n The number of nodes of the graph.
+     */
+    GainHeap(int n) {
+        size = 0;
+        key = utils::SafeMalloc<int>(n);
+        node = utils::SafeMalloc<int>(n);
+        loc = utils::SafeMalloc<int>(n);
+        for(int i=0; i<n; i++) { loc[i] = -1; }
+    }
+    /**
+     * @brief Destructor.
+     */
+    ~GainHeap() {
+        free(key);
+        free(node);
+        free(loc);
+    }
+    bool Empty() { return size == 0; }
+    bool Contains(int v) { return loc[v] != -1; }
+    void Insert(int v, int k) {
+        key[size] = k; node[size] = v; loc[v] = size;
+        size++;
+        Up(size-1);
+    }
+    void Update(int v, int k) {
+        int i = loc[v];
+        int old = key[i];
+        key[i] = k;
+        if(k > old) Up(i);
+        else Down(i);
+    }
+    int Pop() {
+        int v = node[0];
+        loc[v] = -1;
+        size--;
+        if(size > 0) {
+            key[0] = key[size]; node[0] = node[size]; loc[node[0]] = 0;
+            Down(0);
+        }
+        return v;
+    }
+    void Clear() {
+        for(int i=0; i<size; i++) { loc[node[i]] = -1; }
+        size = 0;
+    }
+};
+/**
+ * @brief Coarsen a graph by the heavy-edge matching.
+ * @details The nodes are visited in a random order and each unmatched node
+ * is matched with the unmatched neighbor joined by the heaviest edge. The
+ * matched pairs become the nodes of the coarse graph and the weights of the
+ * parallel edges are summed.
+ * @param g The fine graph.
+ * @param cg A graph to receive the coarse graph.
+ * @param cmap An array to receive the coarse node of each fine node.
+ * @param seed The state of the random numbers.
+ */
+inline void CoarsenGraph(WGraph *g, WGraph *cg, int *cmap, unsigned int *seed)
+{
+    int n = g->n;
+    int *perm = utils::SafeMalloc<int>(n);
+    int *match = utils::SafeMalloc<int>(n);
+    for(int i=0; i<n; i++) { perm[i] = i; match[i] = -1; }
+    for(int i=n-1; i>0; i--) {
+        helper::Swap<int>(&perm[i], &perm[NextRandom(seed)%(i+1)]);
+    }
+    for(int k=0; k<n; k++) {
+        int v = perm[k];
+        if(match[v] != -1) continue;
+        int u = v;
+        int w = 0;
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            if(match[g->adj[j]] == -1 && g->adjw[j] > w) {
+                u = g->adj[j];
+                w = g->adjw[j];
+            }
+        }
+        match[v] = u;
+        match[u] = v;
+    }
+    int cn = 0;
+    for(int v=0; v<n; v++) {
+        if(v > match[v]) continue;
+        cmap[v] = cn;
+        cmap[match[v]] = cn;
+        cn++;
+    }
+    cg->n = cn;
+    cg->xadj = utils::SafeMalloc<int>(cn+1);
+    cg->adj = utils::SafeMalloc<int>(g->xadj[n]);
+    cg->adjw = utils::SafeMalloc<int>(g->xadj[n]);
+    cg->vw = utils::SafeMalloc<int>(cn);
+    int *mark = utils::SafeMalloc<int>(cn);
+    for(int c=0; c<cn; c++) { mark[c] = -1; }
+    int nnz = 0;
+    cg->xadj[0] = 0;
+    for(int v=0; v<n; v++) {
+        if(v > match[v]) continue;
+        int c = cmap[v];
+        cg->vw[c] = g->vw[v];
+        if(match[v] != v) cg->vw[c] += g->vw[match[v]];
+        for(int u=v; ; u=match[v]) {
+            for(int j=g->xadj[u]; j<g->xadj[u+1]; j++) {
+                int cc = cmap[g->adj[j]];
+                if(cc == c) continue;
+                if(mark[cc] == -1) {
+                    mark[cc] = nnz;
+                    cg->adj[nnz] = cc;
+                    cg->adjw[nnz] = g->adjw[j];
+                    nnz++;
+                }else {
+                    cg->adjw[mark[cc]] += g->adjw[j];
+                }
+            }
+            if(u == match[v]) break;
+        }
+        for(int j=cg->xadj[c]; j<nnz; j++) { mark[cg->adj[j]] = -1; }
+        cg->xadj[c+1] = nnz;
+    }
+    free(perm);
+    free(match);
+    free(mark);
+}
+/**
+ * @brief Move a node to the other side of a bisection.
+ * @details The internal and external degrees of the node and its neighbors
+ * and the weights of the sides are updated.
+ * @param g The graph.
+ * @param part The side (0 or 1) of each node.
+ * @param id The weight of the edges of each node to its own side.
+ * @param ed The weight of the edges of each node to the other side.
+ * @param pw The weight of each side.
+ * @param v The node to move.
+ */
+inline void MoveNode(WGraph *g, int *part, int *id, int *ed, int *pw, int v)
+{
+    int s = part[v];
+    part[v] = 1-s;
+    pw[s] -= g->vw[v];
+    pw[1-s] += g->vw[v];
+    helper::Swap<int>(&id[v], &ed[v]);
+    for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+        int u = g->adj[j];
+        if(part[u] == s) { id[u] -= g->adjw[j]; ed[u] += g->adjw[j]; }
+        else { id[u] += g->adjw[j]; ed[u] -= g->adjw[j]; }
+    }
+}
+/**
+ * @brief Refine a bisection by the Fiduccia-Mattheyses method.
+ * @details In each pass the boundary node of the largest gain that fits
+ * into the other side is moved and locked, also when the cut grows, until
+ * the cut has not improved for a while. The pass is then rolled back to the
+ * best state seen, where states that exceed maxw less are better, then the
+ * smaller cut and then the better balance.
+ * @param g The graph.
+ * @param part The side (0 or 1) of each node, which is updated.
+ * @param pw The weight of each side, which is updated.
+ * @param tw The target weight of each side.
+ * @param maxw The maximum weight of each side.
+ * @param npass The maximum number of passes.
+ * @return The weight of the cut edges.
+ */
+inline int FmRefine(WGraph *g, int *part, int *pw, int *tw, int *maxw, int npass)
+{
+    int n = g->n;
+    int *id = utils::SafeCalloc<int>(n);
+    int *ed = utils::SafeCalloc<int>(n);
+    int *moved = utils::SafeMalloc<int>(n);
+    bool *locked = utils::SafeCalloc<bool>(n);
+    int cut = 0;
+    for(int v=0; v<n; v++) {
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            if(part[g->adj[j]] == part[v]) id[v] += g->adjw[j];
+            else ed[v] += g->adjw[j];
+        }
+        cut += ed[v];
+    }
+    cut /= 2;
+    int limit = (n/100 > 25) ? n/100 : 25;
+    GainHeap heap(n);
+    for(int pass=0; pass<npass; pass++) {
+        for(int v=0; v<n; v++) {
+            if(ed[v] > 0) heap.Insert(v, ed[v]-id[v]);
+        }
+        int nm = 0, best = 0, nbad = 0;
+        int best_cut = cut;
+        int best_over = std::max(pw[0]-maxw[0], 0) + std::max(pw[1]-maxw[1], 0);
+        int best_imb = std::abs(pw[0]-tw[0]);
+        while(!heap.Empty()) {
+            int v = heap.Pop();
+            int s = part[v];
+            if(pw[1-s] + g->vw[v] > maxw[1-s]) continue;
+            cut -= ed[v] - id[v];
+            MoveNode(g, part, id, ed, pw, v);
+            locked[v] = true;
+            moved[nm] = v; nm++;
+            for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+                int u = g->adj[j];
+                if(locked[u]) continue;
+                if(heap.Contains(u)) heap.Update(u, ed[u]-id[u]);
+                else if(ed[u] > 0) heap.Insert(u, ed[u]-id[u]);
+            }
+            int over = std::max(pw[0]-maxw[0], 0) + std::max(pw[1]-maxw[1], 0);
+            int imb = std::abs(pw[0]-tw[0]);
+            if(over < best_over || (over == best_over && (cut < best_cut || (cut == best_cut && imb < best_imb)))) {
+                best = nm; best_cut = cut; best_over = over; best_imb = imb;
+                nbad = 0;
+            }else {
+                nbad++;
+                if(nbad > limit) break;
+            }
+        }
+        heap.Clear();
+        for(int k=nm-1; k>=best; k--) { MoveNode(g, part, id, ed, pw, moved[k]); }
+        for(int k=0; k<nm; k++) { locked[moved[k]] = false; }
+        cut = best_cut;
+        if(best == 0) break;
+    }
+    free(id);
+    free(ed);
+    free(moved);
+    free(locked);
+    return cut;
+}
+/**
+ * @brief Compute an initial bisection of a (coarse) graph by graph growing.
+ * @details Side 0 is grown breadth-first from a random node until it reaches
+ * its target weight and the result is refined by FmRefine. The best of
+ * several trials is kept.
+ * @param g The graph.
+ * @param part An array to receive the side (0 or 1) of each node.
+ * @param pw An array to receive the weight of each side.
+ * @param tw The target weight of each side.
+ * @param maxw The maximum weight of each side.
+ * @param seed The state of the random numbers.
+ */
+inline void GrowBisection(WGraph *g, int *part, int *pw, int *tw, int *maxw, unsigned int *seed)
+{
+    int n = g->n;
+    int *tmp = utils::SafeMalloc<int>(n);
+    int *queue = utils::SafeMalloc<int>(n);
+    bool *visited = utils::SafeMalloc<bool>(n);
+    int best_cut = -1, best_over = 0;
+    for(int trial=0; trial<4; trial++) {
+        for(int v=0; v<n; v++) { tmp[v] = 1; visited[v] = false; }
+        int tpw[2] = {0, tw[0]+tw[1]};
+        int qs = 0, qe = 0;
+        int next = NextRandom(seed) % n;
+        while(tpw[0] < tw[0]) {
+            if(qs == qe) {
+                // A new component
+                while(qe < n && visited[next]) next = (next+1) % n;
+                if(qe == n) break;
+                visited[next] = true;
+                queue[qe] = next; qe++;
+            }
+            int v = queue[qs]; qs++;
+            if(tpw[0] + g->vw[v] > maxw[0]) continue;
+            tmp[v] = 0;
+            tpw[0] += g->vw[v];
+            tpw[1] -= g->vw[v];
+            for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+                if(visited[g->adj[j]]) continue;
+                visited[g->adj[j]] = true;
+                queue[qe] = g->adj[j]; qe++;
+            }
+        }
+        int cut = FmRefine(g, tmp, tpw, tw, maxw, 4);
+        int over = std::max(tpw[0]-maxw[0], 0) + std::max(tpw[1]-maxw[1], 0);
+        if(best_cut == -1 || over < best_over || (over == best_over && cut < best_cut)) {
+            best_cut = cut;
+            best_over = over;
+            for(int v=0; v<n; v++) { part[v] = tmp[v]; }
+            pw[0] = tpw[0];
+            pw[1] = tpw[1];
+        }
+    }
+    free(tmp);
+    free(queue);
+    free(visited);
+}
+/**
+ * @brief Make the weight of side 0 of a bisection exactly its target.
+ * @details The nodes of the heavier side of the largest gain are moved, so
+ * the cut grows as little as possible. The target is met exactly when all
+ * node weights are 1.
+ * @param g The graph.
+ * @param part The side (0 or 1) of each node, which is updated.
+ * @param pw The weight of each side, which is updated.
+ * @param tw The target weight of each side.
+ */
+inline void ExactBisection(WGraph *g, int *part, int *pw, int *tw)
+{
+    if(pw[0] == tw[0]) return;
+    int n = g->n;
+    int s = (pw[0] > tw[0]) ? 0 : 1;
+    int *id = utils::SafeCalloc<int>(n);
+    int *ed = utils::SafeCalloc<int>(n);
+    GainHeap heap(n);
+    for(int v=0; v<n; v++) {
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            if(part[g->adj[j]] == part[v]) id[v] += g->adjw[j];
+            else ed[v] += g->adjw[j];
+        }
+        if(part[v] == s) heap.Insert(v, ed[v]-id[v]);
+    }
+    while(pw[s] > tw[s] && !heap.Empty()) {
+        int v = heap.Pop();
+        if(pw[s] - g->vw[v] < tw[s]) continue;
+        MoveNode(g, part, id, ed, pw, v);
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            int u = g->adj[j];
+            if(heap.Contains(u)) heap.Update(u, ed[u]-id[u]);
+        }
+    }
+    free(id);
+    free(ed);
+}
+/**
+ * @brief Bisect a graph by the multilevel method.
+ * @details The graph is coarsened by CoarsenGraph until it is small, the
+ * coarsest graph is bisected by GrowBisection, and the bisection is
+ * projected back level by level and refined by FmRefine on each level.
+ * Finally the weights of the sides are fixed by ExactBisection.
+ * @param g The graph.
+ * @param part An array to receive the side (0 or 1) of each node.
+ * @param tw0 The target weight of side 0.
+ * @param seed The state of the random numbers.
+ */
+inline void MultilevelBisection(WGraph *g, int *part, int tw0, unsigned int *seed)
+{
+    const int max_level = 32;
+    WGraph *gs = utils::SafeMalloc<WGraph>(max_level+1);
+    int **cmap = utils::SafeMalloc<int*>(max_level);
+    int **parts = utils::SafeMalloc<int*>(max_level+1);
+    gs[0] = *g;
+    int nl = 0;
+    while(gs[nl].n > 64 && nl < max_level) {
+        cmap[nl] = utils::SafeMalloc<int>(gs[nl].n);
+        CoarsenGraph(&gs[nl], &gs[nl+1], cmap[nl], seed);
+        if(gs[nl+1].n > 0.9 * gs[nl].n) {
+            FreeWGraph(&gs[nl+1]);
+            free(cmap[nl]);
+            break;
+        }
+        nl++;
+    }
+    int total = 0;
+    for(int v=0; v<g->n; v++) { total += g->vw[v]; }
+    int tw[2] = {tw0, total-tw0};
+    int pw[2], maxw[2];
+    parts[0] = part;
+    for(int l=nl; l>=0; l--) {
+        int maxvw = 1;
+        for(int v=0; v<gs[l].n; v++) { maxvw = std::max(maxvw, gs[l].vw[v]); }
+        for(int s=0; s<2; s++) { maxw[s] = tw[s] + std::max(tw[s]*3/100, maxvw-1); }
+        if(l == nl) {
+            if(l > 0) parts[l] = utils::SafeMalloc<int>(gs[l].n);
+            GrowBisection(&gs[l], parts[l], pw, tw, maxw, seed);
+        }else {
+            if(l > 0) parts[l] = utils::SafeMalloc<int>(gs[l].n);
+            for(int v=0; v<gs[l].n; v++) { parts[l][v] = parts[l+1][cmap[l][v]]; }
+            FmRefine(&gs[l], parts[l], pw, tw, maxw, 8);
+            free(parts[l+1]);
+            FreeWGraph(&gs[l+1]);
+            free(cmap[l]);
+        }
+    }
+    ExactBisection(g, part, pw, tw);
+    free(gs);
+    free(cmap);
+    free(parts);
+}
+/**
+ * @brief Extract the subgraph induced by the nodes of one side.
+ * @param g The graph.
+ * @param label The global index of each node.
+ * @param side The side of each node.
+ * @param s The side to extract.
+ * @param sg A graph to receive the subgraph.
+ * @param sl A pointer to receive the global index of each node of the subgraph.
+ */
+inline void InducedSubgraph(WGraph *g, int *label, int *side, int s, WGraph *sg, int **sl)
+{
+    int n = g->n;
+    int *loc = utils::SafeMalloc<int>(n);
+    int cnt = 0, nnz = 0;
+    for(int v=0; v<n; v++) {
+        if(side[v] != s) continue;
+        loc[v] = cnt; cnt++;
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            if(side[g->adj[j]] == s) nnz++;
+        }
+    }
+    sg->n = cnt;
+    sg->xadj = utils::SafeMalloc<int>(cnt+1);
+    sg->adj = utils::SafeMalloc<int>(nnz);
+    sg->adjw = utils::SafeMalloc<int>(nnz);
+    sg->vw = utils::SafeMalloc<int>(cnt);
+    *sl = utils::SafeMalloc<int>(cnt);
+    nnz = 0;
+    sg->xadj[0] = 0;
+    for(int v=0; v<n; v++) {
+        if(side[v] != s) continue;
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            if(side[g->adj[j]] != s) continue;
+            sg->adj[nnz] = loc[g->adj[j]];
+            sg->adjw[nnz] = g->adjw[j];
+            nnz++;
+        }
+        sg->xadj[loc[v]+1] = nnz;
+        sg->vw[loc[v]] = g->vw[v];
+        (*sl)[loc[v]] = label[v];
+    }
+    free(loc);
+}
+/**
+ * @brief Partition a graph into k parts by recursive multilevel bisection.
+ * @details Each graph is split into the parts first, ..., first+floor(k/2)-1
+ * and the rest, with the target weights taken from pp, and the two induced
+ * subgraphs are partitioned recursively.
+ * @param g The graph.
+ * @param label The global index of each node.
+ * @param k The number of parts.
+ * @param first The index of the first part.
+ * @param part An array that receives the part of each global index.
+ * @param pp The target weight of the parts before each part (prefix sums).
+ * @param seed The state of the random numbers.
+ */
+inline void RecursiveBisection(WGraph *g, int *label, int k, int first, int *part, long *pp, unsigned int *seed)
+{
+    int n = g->n;
+    if(k == 1 || n == 0) {
+        for(int v=0; v<n; v++) { part[label[v]] = first; }
+        return;
+    }
+    int k0 = k/2;
+    int *side = utils::SafeMalloc<int>(n);
+    MultilevelBisection(g, side, (int)(pp[first+k0] - pp[first]), seed);
+    for(int s=0; s<2; s++) {
+        WGraph sg;
+        int *sl;
+        InducedSubgraph(g, label, side, s, &sg, &sl);
+        if(s == 0) RecursiveBisection(&sg, sl, k0, first, part, pp, seed);
+        else RecursiveBisection(&sg, sl, k-k0, first+k0, part, pp, seed);
+        FreeWGraph(&sg);
+        free(sl);
+    }
+    free(side);
+}
+/**
+ * @brief Build the graph of a matrix with unit weights for the multilevel partitioner.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param g A graph to receive the symmetrized graph without self loops.
+ * @param label A pointer to receive the identity labels.
+ * @param N The size of the input graph (matrix)
+ * @param isSym Whether the input matrix is symmetric or not.
+ */
+inline void BuildWGraph(int *cind, int *rptr, WGraph *g, int **label, int N, bool isSym)
+{
+    int *am_cind;
+    int *am_rptr;
+    GetAdjacency(cind, rptr, &am_cind, &am_rptr, N, isSym);
+    g->n = N;
+    g->xadj = utils::SafeMalloc<int>(N+1);
+    g->adj = utils::SafeMalloc<int>(am_rptr[N]);
+    g->adjw = utils::SafeMalloc<int>(am_rptr[N]);
+    g->vw = utils::SafeMalloc<int>(N);
+    *label = utils::SafeMalloc<int>(N);
+    int nnz = 0;
+    g->xadj[0] = 0;
+    for(int i=0; i<N; i++) {
+        for(int j=am_rptr[i]; j<am_rptr[i+1]; j++) {
+            if(am_cind[j] == i) continue;
+            g->adj[nnz] = am_cind[j];
+            g->adjw[nnz] = 1;
+            nnz++;
+        }
+        g->xadj[i+1] = nnz;
+        g->vw[i] = 1;
+        (*label)[i] = i;
+    }
+    free(am_cind);
+    free(am_rptr);
+}
+/**
+ * @brief Partition a graph into parts with few edges between them by the multilevel method.
+ * @details The graph is bisected recursively by MultilevelBisection, which
+ * coarsens by the heavy-edge matching, bisects the coarsest graph by graph
+ * growing and refines by the Fiduccia-Mattheyses method while uncoarsening.
+ * Part k gets exactly size[k] nodes, by default
+ * floor((k+1)*N/num_part)-floor(k*N/num_part), which are the blocks of
+ * matrix::RemoveOffDiagonal. The result is deterministic.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param part A pointer to receive the part of each node.
+ * @param N The size of the input graph (matrix)
+ * @param num_part The number of parts.
+ * @param isSym Whether the input matrix is symmetric or not.
+ * @param size The number of nodes of each part, which must sum to N (nullptr for the default).
+ */
+inline void MultilevelPartition(
+    int *cind, int *rptr, int **part,
+    int N, int num_part, bool isSym, const int *size = nullptr)
+{
+    long *pp = utils::SafeMalloc<long>(num_part+1);
+    pp[0] = 0;
+    for(int k=0; k<num_part; k++) {
+        pp[k+1] = (size == nullptr) ? (long)(k+1)*N/num_part : pp[k] + size[k];
+    }
+    if(pp[num_part] != N) {
+        printf("Error: MultilevelPartition, the sizes of the parts do not sum to N\n");
+        exit(1);
+    }
+    WGraph g;
+    int *label;
+    BuildWGraph(cind, rptr, &g, &label, N, isSym);
+    *part = utils::SafeMalloc<int>(N);
+    unsigned int seed = 2463534242u;
+    RecursiveBisection(&g, label, num_part, 0, *part, pp, &seed);
+    FreeWGraph(&g);
+    free(label);
+    free(pp);
+}
+/**
+ * @brief Create an permutation matrix that numbers the parts of MultilevelPartition consecutively.
+ * @details The nodes of each part keep their relative order. By default part k
+ * occupies rows floor(k*N/num_part), ..., floor((k+1)*N/num_part)-1, which
+ * are the blocks used by matrix::RemoveOffDiagonal for block Jacobi.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param LP A pointer to the resulting vector representing the left permutation matrix.
+ * @param RP A pointer to the resulting vector representing the right permutation matrix.
+ * @param N The size of the input graph (matrix)
+ * @param num_part The number of parts.
+ * @param isSym Whether the input matrix is symmetric or not.
+ * @param size The number of nodes of each part (see MultilevelPartition).
+ */
+inline void GetPartitionPermutation(
+    int *cind, int *rptr, int **LP, int **RP,
+    int N, int num_part, bool isSym, const int *size = nullptr)
+{
+    int *part;
+    MultilevelPartition(cind, rptr, &part, N, num_part, isSym, size);
+    int *ptr = utils::SafeCalloc<int>(num_part+1);
+    for(int i=0; i<N; i++) { ptr[part[i]+1]++; }
+    for(int k=0; k<num_part; k++) { ptr[k+1] += ptr[k]; }
+    *LP = utils::SafeMalloc<int>(N);
+    *RP = utils::SafeMalloc<int>(N);
+    for(int i=0; i<N; i++) {
+        (*LP)[ptr[part[i]]] = i;
+        ptr[part[i]]++;
+    }
+    for(int i=0; i<N; i++) { (*RP)[(*LP)[i]] = i; }
+    free(part);
+    free(ptr);
+}
+/**
+ * @brief Order a graph by nested dissection.
+ * @details The graph is bisected by MultilevelBisection and the boundary
+ * nodes of the side that has fewer of them form the vertex separator. The
+ * two remaining parts are ordered recursively, followed by the separator.
+ * Graphs of at most leaf nodes keep their relative order.
+ * @param g The graph.
+ * @param label The global index of each node.
+ * @param order An array to receive the global indices of the nodes in the new order.
+ * @param leaf The size under which a graph is not dissected.
+ * @param seed The state of the random numbers.
+ */
+inline void NestedDissection(WGraph *g, int *label, int *order, int leaf, unsigned int *seed)
+{
+    int n = g->n;
+    if(n <= leaf) {
+        for(int v=0; v<n; v++) { order[v] = label[v]; }
+        return;
+    }
+    int total = 0;
+    for(int v=0; v<n; v++) { total += g->vw[v]; }
+    int *side = utils::SafeMalloc<int>(n);
+    MultilevelBisection(g, side, total/2, seed);
+    // Vertex separator
+    bool *bnd = utils::SafeCalloc<bool>(n);
+    int nb[2] = {0, 0};
+    for(int v=0; v<n; v++) {
+        for(int j=g->xadj[v]; j<g->xadj[v+1]; j++) {
+            if(side[g->adj[j]] != side[v]) { bnd[v] = true; break; }
+        }
+        if(bnd[v]) nb[side[v]]++;
+    }
+    int sep = (nb[0] <= nb[1]) ? 0 : 1;
+    for(int v=0; v<n; v++) {
+        if(bnd[v] && side[v] == sep) side[v] = 2;
+    }
     int cnt = 0;
-    while(cnt < N) {
-        for(int i=0; i<N; i++) {
-            if(visit[i] == now || (*color)[i] != 0) continue;
-            (*color)[i] = now;
-            cnt++;
-            for(int j=rptr[i]; j<rptr[i+1]; j++) {
-                visit[cind[j]] = now;
+    for(int s=0; s<2; s++) {
+        WGraph sg;
+        int *sl;
+        InducedSubgraph(g, label, side, s, &sg, &sl);
+        NestedDissection(&sg, sl, &order[cnt], leaf, seed);
+        cnt += sg.n;
+        FreeWGraph(&sg);
+        free(sl);
+    }
+    for(int v=0; v<n; v++) {
+        if(side[v] == 2) { order[cnt] = label[v]; cnt++; }
+    }
+    free(side);
+    free(bnd);
+}
+/**
+ * @brief Create an permutation matrix based on the nested dissection ordering.
+ * @details The ordering reduces the fill of the (incomplete) factorizations
+ * on 2-D and 3-D meshes. See NestedDissection. The result is deterministic.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param LP A pointer to the resulting vector representing the left permutation matrix.
+ * @param RP A pointer to the resulting vector representing the right permutation matrix.
+ * @param N The size of the input graph (matrix)
+ * @param isSym Whether the input matrix is symmetric or not.
+ * @param leaf The size under which a subgraph is not dissected.
+ */
+inline void GetNDPermutation(
+    int *cind, int *rptr, int **LP, int **RP,
+    int N, bool isSym, int leaf = 64)
+{
+    WGraph g;
+    int *label;
+    BuildWGraph(cind, rptr, &g, &label, N, isSym);
+    *LP = utils::SafeMalloc<int>(N);
+    *RP = utils::SafeMalloc<int>(N);
+    unsigned int seed = 2463534242u;
+    NestedDissection(&g, label, *LP, (leaf < 1) ? 1 : leaf, &seed);
+    for(int i=0; i<N; i++) { (*RP)[(*LP)[i]] = i; }
+    FreeWGraph(&g);
+    free(label);
+}
+/**
+ * @brief Count the nonzeros of the complete factor L of the symmetrized pattern of a matrix.
+ * @details The elimination tree is built and the pattern of each row of L
+ * is found by walking up the tree from the entries of the row, so only O(N)
+ * memory is used. The complete LU factors have 2 * count - N nonzeros, which
+ * bounds the pattern of ILU(p) for every p.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param N The size of the input graph (matrix)
+ * @param isSym Whether the input matrix is symmetric or not.
+ * @return The number of nonzeros of L including the diagonal.
+ */
+inline long CholeskyNnz(int *cind, int *rptr, int N, bool isSym)
+{
+    int *am_cind;
+    int *am_rptr;
+    GetAdjacency(cind, rptr, &am_cind, &am_rptr, N, isSym);
+    int *parent = utils::SafeMalloc<int>(N);
+    int *ancestor = utils::SafeMalloc<int>(N);
+    int *mark = utils::SafeMalloc<int>(N);
+    // Elimination tree with path compression
+    for(int i=0; i<N; i++) {
+        parent[i] = -1;
+        ancestor[i] = -1;
+        for(int j=am_rptr[i]; j<am_rptr[i+1]; j++) {
+            int k = am_cind[j];
+            while(k != -1 && k < i) {
+                int next = ancestor[k];
+                ancestor[k] = i;
+                if(next == -1) parent[k] = i;
+                k = next;
+            }
+        }
+    }
+    // Row subtrees
+    long cnt = 0;
+    for(int i=0; i<N; i++) {
+        mark[i] = i;
+        cnt++;
+        for(int j=am_rptr[i]; j<am_rptr[i+1]; j++) {
+            int k = am_cind[j];
+            if(k > i) continue;
+            while(mark[k] != i) {
+                mark[k] = i;
+                cnt++;
+                k = parent[k];
+            }
+        }
+    }
+    free(am_cind);
+    free(am_rptr);
+    free(parent);
+    free(ancestor);
+    free(mark);
+    return cnt;
+}
+/**
+ * @brief Number a connected component in the Cuthill-McKee order from a root, by a parallel level-synchronous BFS.
+ * @details The children of the frontier are claimed by their first parent in
+ * the frontier order and are sorted by degree (then index) under it, so the
+ * result is that of the sequential Cuthill-McKee algorithm. pos and owner
+ * must be -1 for the nodes of the component.
+ * @param cind An array that stores column indices of a symmetric pattern.
+ * @param rptr An array that stores row pointer.
+ * @param root The starting node.
+ * @param order An array to receive the nodes from order[start].
+ * @param start The position of the root in order.
+ * @param pos An array that maps the numbered nodes to their position in order.
+ * @param owner A work array of size N.
+ * @param cnt A work array of size N+1.
+ * @param num_level A variable to receive the number of levels.
+ * @param last A variable to receive the position of the first node of the last level.
+ * @return The position next to the last numbered node.
+ */
+inline int CuthillMcKee(
+    int *cind, int *rptr, int root,
+    int *order, int start, int *pos, int *owner, int *cnt,
+    int *num_level, int *last)
+{
+    order[start] = root;
+    pos[root] = start;
+    int fs = start;
+    int fe = start+1;
+    *num_level = 1;
+    while(true) {
+        // Children claimed by each node of the frontier
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(int p=fs; p<fe; p++) {
+            int u = order[p];
+            int c = 0;
+            for(int j=rptr[u]; j<rptr[u+1]; j++) {
+                int v = cind[j];
+                if(pos[v] != -1) continue;
+                bool first = true;
+                for(int k=rptr[v]; k<rptr[v+1]; k++) {
+                    int q = pos[cind[k]];
+                    if(q >= fs && q < p) { first = false; break; }
+                }
+                if(first) { owner[v] = p; c++; }
+            }
+            cnt[p-fs+1] = c;
+        }
+        cnt[0] = fe;
+        for(int p=fs; p<fe; p++) { cnt[p-fs+1] += cnt[p-fs]; }
+        int ne = cnt[fe-fs];
+        if(ne == fe) break;
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(int p=fs; p<fe; p++) {
+            int u = order[p];
+            int s = cnt[p-fs];
+            int e = s;
+            for(int j=rptr[u]; j<rptr[u+1]; j++) {
+                int v = cind[j];
+                if(owner[v] != p) continue;
+                // Insertion by (degree, index)
+                int d = rptr[v+1] - rptr[v];
+                int k = e;
+                while(k > s) {
+                    int w = order[k-1];
+                    int dw = rptr[w+1] - rptr[w];
+                    if(dw < d || (dw == d && w < v)) break;
+                    order[k] = w;
+                    k--;
+                }
+                order[k] = v;
+                e++;
             }
+            for(int k=s; k<e; k++) { pos[order[k]] = k; }
+        }
+        fs = fe;
+        fe = ne;
+        (*num_level)++;
+    }
+    *last = fs;
+    return fe;
+}
+/**
+ * @brief Create an permutation matrix based on the reverse Cuthill-McKee ordering.
+ * @details Each connected component is numbered from a pseudo-peripheral node
+ * found by the algorithm of George and Liu, starting from its node of the
+ * smallest index. The result does not depend on the number of threads.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param LP A pointer to the resulting vector representing the left permutation matrix.
+ * @param RP A pointer to the resulting vector representing the right permutation matrix.
+ * @param N The size of the input graph (matrix)
+ * @param isSym Whether the input matrix is symmetric or not.
+ */
+inline void GetRCMPermutation(
+    int *cind, int *rptr, int **LP, int **RP,
+    int N, bool isSym)
+{
+    int *am_cind;
+    int *am_rptr;
+    GetAdjacency(cind, rptr, &am_cind, &am_rptr, N, isSym);
+    int *order = utils::SafeMalloc<int>(N);
+    int *pos = utils::SafeMalloc<int>(N);
+    int *owner = utils::SafeMalloc<int>(N);
+    int *cnt = utils::SafeMalloc<int>(N+1);
+    for(int i=0; i<N; i++) { pos[i] = -1; owner[i] = -1; }
+    int start = 0;
+    for(int i=0; i<N; i++) {
+        if(pos[i] != -1) continue;
+        // Pseudo-peripheral node
+        int root = i;
+        int cand = i;
+        int best = 0;
+        int num_level, last;
+        while(true) {
+            int end = CuthillMcKee(am_cind, am_rptr, cand, order, start, pos, owner, cnt, &num_level, &last);
+            int next = order[last];
+            for(int k=last+1; k<end; k++) {
+                int v = order[k];
+                int dv = am_rptr[v+1] - am_rptr[v];
+                int dn = am_rptr[next+1] - am_rptr[next];
+                if(dv < dn || (dv == dn && v < next)) next = v;
+            }
+            for(int k=start; k<end; k++) { pos[order[k]] = -1; owner[order[k]] = -1; }
+            if(num_level <= best) break;
+            best = num_level;
+            root = cand;
+            if(next == cand) break;
+            cand = next;
+        }
+        start = CuthillMcKee(am_cind, am_rptr, root, order, start, pos, owner, cnt, &num_level, &last);
+    }
+    *LP = utils::SafeMalloc<int>(N);
+    *RP = utils::SafeMalloc<int>(N);
+    for(int i=0; i<N; i++) {
+        (*LP)[i] = order[N-1-i];
+        (*RP)[(*LP)[i]] = i;
+    }
+    free(am_cind);
+    free(am_rptr);
+    free(order);
+    free(pos);
+    free(owner);
+    free(cnt);
+}
+/**
+ * @brief Compute the pattern of the matrix permuted by LP and RP, with sorted column indices.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param LP The vector representing the left permutation matrix.
+ * @param RP The vector representing the right permutation matrix.
+ * @param p_cind A pointer to receive the column indices of the permuted pattern.
+ * @param p_rptr A pointer to receive the row pointer of the permuted pattern.
+ * @param N The size of the input graph (matrix)
+ */
+static void PermutePattern(
+    int *cind, int *rptr, int *LP, int *RP,
+    int **p_cind, int **p_rptr, int N)
+{
+    *p_cind = utils::SafeMalloc<int>(rptr[N]);
+    *p_rptr = utils::SafeMalloc<int>(N+1);
+    (*p_rptr)[0] = 0;
+    for(int i=0; i<N; i++) {
+        (*p_rptr)[i+1] = (*p_rptr)[i] + rptr[LP[i]+1] - rptr[LP[i]];
+    }
+    #pragma omp parallel for
+    for(int i=0; i<N; i++) {
+        int id = LP[i];
+        for(int j=0; j<rptr[id+1]-rptr[id]; j++) {
+            (*p_cind)[(*p_rptr)[i]+j] = RP[cind[rptr[id]+j]];
         }
-        now++;
+        if((*p_rptr)[i+1] - (*p_rptr)[i] > 1) helper::QuickSort<int>(*p_cind, (*p_rptr)[i], (*p_rptr)[i+1]-1);
     }
-    *num_color = now - 1;
-    free(visit);
 }
 /**
  * @brief Create an permutation matrix based on the AMC ordering technique@cite iwashita2002AMC.
@@ -246,34 +1507,46 @@ static void Coloring( // Greedy Coloring
  * @param RP A pointer to the resulting vector representing the right permutation matrix.
  * @param N The size of the input graph (matrix)
  * @param isSym Whether the input matrix is symmetric or not.
+ * @param cmethod Specify the coloring method: "greedy", "parallel" or "balanced".
+ * @param min_size The minimum size of a color for "balanced" (see BalanceColoring).
  */
 void GetAMCPermutation(
     int *cind, int *rptr,
     int *num_color, int **size_color, int **LP, int **RP,
-    int N, bool isSym)
+    int N, bool isSym, const char *cmethod = "greedy", int min_size = 0)
 {
     int *am_cind;
     int *am_rptr;
     GetAdjacency(cind, rptr, &am_cind, &am_rptr, N, isSym);
     int *color;
-    // Greedy Coloring
-    Coloring(am_cind, am_rptr, &color, num_color, N);
+    if(std::strcmp(cmethod, "greedy") == 0) {
+        Coloring(am_cind, am_rptr, &color, num_color, N);
+    }else if(std::strcmp(cmethod, "parallel") == 0) {
+        ParallelColoring(am_cind, am_rptr, &color, num_color, N);
+    }else if(std::strcmp(cmethod, "balanced") == 0) {
+        Coloring(am_cind, am_rptr, &color, num_color, N);
+        BalanceColoring(am_cind, am_rptr, color, num_color, N, min_size);
+    }else {
+        printf("Error: GetAMCPermutation\n");
+        printf("The coloring method is invalid\n");
+        exit(1);
+    }
     *LP = utils::SafeMalloc<int>(N);
-    *size_color = utils::SafeMalloc<int>(*num_color+1);
-    (*size_color)[0] = 0;
-    int cnt = 0;
-    for(int i=0; i<*num_color; i++) {
-        int temp_cnt = 0;
-        for(int j=0; j<N; j++) {
-            if(color[j]-1 != i) continue;
-            (*LP)[cnt] = j;
-            cnt++;
-            temp_cnt++;
-        }
-        (*size_color)[i+1] = (*size_color)[i] + temp_cnt;
+    *size_color = utils::SafeCalloc<int>(*num_color+1);
+    for(int j=0; j<N; j++) { (*size_color)[color[j]]++; }
+    for(int i=0; i<*num_color; i++) { (*size_color)[i+1] += (*size_color)[i]; }
+    int *pos = utils::SafeMalloc<int>(*num_color);
+    for(int i=0; i<*num_color; i++) { pos[i] = (*size_color)[i]; }
+    for(int j=0; j<N; j++) {
+        (*LP)[pos[color[j]-1]] = j;
+        pos[color[j]-1]++;
     }
+    free(pos);
     *RP = utils::SafeMalloc<int>(N);
     for(int i=0; i<N; i++) {(*RP)[(*LP)[i]] = i;}
+    free(am_cind);
+    free(am_rptr);
+    free(color);
 }
 /**
  * @brief Create an permutation matrix based on the ABMC ordering technique@cite iwashita2012ABMC, @cite li2019enhancement.
@@ -284,19 +1557,21 @@ void GetAMCPermutation(
  * @param LP A pointer to the resulting vector representing the left permutation matrix.
  * @param RP A pointer to the resulting vector representing the right permutation matrix.
  * @param N The size of the input graph (matrix)
- * @param bsize The size of the block.
+ * @param bsize The size of the block. If it does not divide N, the last block is smaller.
  * @param isSym Whether the input matrix is symmetric or not.
- * @param bmethod Specify the blocking method: "simple" or "connect".
+ * @param bmethod Specify the blocking method: "simple", "connect", "rcm" (connect on the RCM ordered graph) or "multilevel" (the parts of MultilevelPartition).
+ * @param cmethod Specify the coloring method: "greedy", "parallel" or "balanced".
+ * @param min_size The minimum size of a color for "balanced" (see BalanceColoring).
  */
 void GetABMCPermutation(
     int *cind, int *rptr,
     int *num_color, int **size_color, int **LP, int **RP,
-    int N, int bsize, bool isSym, const char *bmethod)
+    int N, int bsize, bool isSym, const char *bmethod,
+    const char *cmethod = "greedy", int min_size = 0)
 {
-    if(N%bsize) {
-        printf("Error: GetABMCPermutation\n");
-        exit(1);
-    }
+    // When bsize does not divide N, the last block is smaller and is
+    // ordered last.
+    int nb = (N+bsize-1)/bsize;
     int *b_cind;
     int *b_rptr;
     int *block;
@@ -304,6 +1579,33 @@ void GetABMCPermutation(
         SimpleBlocking(cind, rptr, &b_cind, &b_rptr, &block, N, bsize);
     }else if(std::strcmp(bmethod, "connect") == 0) {
         ConnectedBlocking(cind, rptr, &b_cind, &b_rptr, &block, N, bsize);
+    }else if(std::strcmp(bmethod, "rcm") == 0) {
+        // Connected blocking on the RCM ordered graph
+        int *r_LP, *r_RP;
+        GetRCMPermutation(cind, rptr, &r_LP, &r_RP, N, isSym);
+        int *p_cind, *p_rptr;
+        PermutePattern(cind, rptr, r_LP, r_RP, &p_cind, &p_rptr, N);
+        ConnectedBlocking(p_cind, p_rptr, &b_cind, &b_rptr, &block, N, bsize);
+        for(int i=0; i<N; i++) { block[i] = r_LP[block[i]]; }
+        free(r_LP);
+        free(r_RP);
+        free(p_cind);
+        free(p_rptr);
+    }else if(std::strcmp(bmethod, "multilevel") == 0) {
+        // The parts of MultilevelPartition, numbered consecutively, as blocks
+        int *m_LP, *m_RP;
+        int *size = utils::SafeMalloc<int>(nb);
+        for(int i=0; i<nb; i++) { size[i] = std::min(bsize, N-i*bsize); }
+        GetPartitionPermutation(cind, rptr, &m_LP, &m_RP, N, nb, isSym, size);
+        free(size);
+        int *p_cind, *p_rptr;
+        PermutePattern(cind, rptr, m_LP, m_RP, &p_cind, &p_rptr, N);
+        SimpleBlocking(p_cind, p_rptr, &b_cind, &b_rptr, &block, N, bsize);
+        for(int i=0; i<N; i++) { block[i] = m_LP[block[i]]; }
+        free(m_LP);
+        free(m_RP);
+        free(p_cind);
+        free(p_rptr);
     }else {
         printf("Error: GetABMCPermutation\n");
         printf("The blocking method is invalid\n");
@@ -311,26 +1613,186 @@ void GetABMCPermutation(
     }
     int *am_cind;
     int *am_rptr;
-    GetAdjacency(b_cind, b_rptr, &am_cind, &am_rptr, N/bsize, isSym);
+    GetAdjacency(b_cind, b_rptr, &am_cind, &am_rptr, nb, isSym);
     int *color;
-    // Greedy Coloring
-    Coloring(am_cind, am_rptr, &color, num_color, N/bsize);
+    if(std::strcmp(cmethod, "greedy") == 0) {
+        Coloring(am_cind, am_rptr, &color, num_color, nb);
+    }else if(std::strcmp(cmethod, "parallel") == 0) {
+        ParallelColoring(am_cind, am_rptr, &color, num_color, nb);
+    }else if(std::strcmp(cmethod, "balanced") == 0) {
+        Coloring(am_cind, am_rptr, &color, num_color, nb);
+        BalanceColoring(am_cind, am_rptr, color, num_color, nb, min_size);
+    }else {
+        printf("Error: GetABMCPermutation\n");
+        printf("The coloring method is invalid\n");
+        exit(1);
+    }
+    if(N%bsize) {
+        // Move the color of the last block to the end
+        int c = color[nb-1];
+        for(int j=0; j<nb; j++) {
+            if(color[j] == c) color[j] = *num_color;
+            else if(color[j] == *num_color) color[j] = c;
+        }
+    }
     *LP = utils::SafeMalloc<int>(N);
-    *size_color = utils::SafeMalloc<int>(*num_color+1);
-    (*size_color)[0] = 0;
+    *size_color = utils::SafeCalloc<int>(*num_color+1);
+    for(int j=0; j<nb; j++) { (*size_color)[color[j]]++; }
+    for(int i=0; i<*num_color; i++) { (*size_color)[i+1] += (*size_color)[i]; }
+    int *pos = utils::SafeMalloc<int>(*num_color);
+    for(int i=0; i<*num_color; i++) { pos[i] = (*size_color)[i]; }
+    for(int j=0; j<nb; j++) {
+        int cnt = pos[color[j]-1]*bsize;
+        for(int k=0; k<bsize && j*bsize+k<N; k++) {
+            (*LP)[cnt+k] = block[j*bsize+k];
+        }
+        pos[color[j]-1]++;
+    }
+    free(pos);
+    *RP = utils::SafeMalloc<int>(N);
+    for(int i=0; i<N; i++) {(*RP)[(*LP)[i]] = i;}
+    free(b_cind);
+    free(b_rptr);
+    free(block);
+    free(am_cind);
+    free(am_rptr);
+    free(color);
+}
+/**
+ * @brief Create an permutation matrix based on a hierarchical (two-level) ABMC ordering.
+ * @details The inner blocks of bsize nodes are made by connected blocking
+ * and are sized for the BCSR blocks (bnl rows). They are grouped into about
+ * N/sbsize super-blocks with few couplings by MultilevelPartition, so that a
+ * super-block fits in the cache, and the graph of the super-blocks is
+ * colored. The new order lists the super-blocks color by color and the inner
+ * blocks within each super-block. The super-blocks may differ in size by
+ * inner blocks, so their positions are returned in sptr. When bsize does not
+ * divide N, the last inner block is smaller and is ordered last.
+ * @param cind An array that stores column indices.
+ * @param rptr An array that stores row pointer.
+ * @param num_color A variable to receive the number of colors.
+ * @param size_color A pointer to receive the first super-block of each color (num_color+1 entries).
+ * @param sptr A pointer to receive the first row of each super-block in the new order.
+ * @param LP A pointer to the resulting vector representing the left permutation matrix.
+ * @param RP A pointer to the resulting vector representing the right permutation matrix.
+ * @param N The size of the input graph (matrix)
+ * @param bsize The size of the inner block.
+ * @param sbsize The target size of the super-block, a multiple of bsize.
+ * @param isSym Whether the input matrix is symmetric or not.
+ * @param cmethod Specify the coloring method: "greedy", "parallel" or "balanced".
+ * @param min_size The minimum size of a color for "balanced" (see BalanceColoring).
+ */
+void GetHABMCPermutation(
+    int *cind, int *rptr,
+    int *num_color, int **size_color, int **sptr, int **LP, int **RP,
+    int N, int bsize, int sbsize, bool isSym,
+    const char *cmethod = "greedy", int min_size = 0)
+{
+    if(sbsize%bsize) {
+        printf("Error: GetHABMCPermutation\n");
+        exit(1);
+    }
+    int *b_cind;
+    int *b_rptr;
+    int *block;
+    ConnectedBlocking(cind, rptr, &b_cind, &b_rptr, &block, N, bsize);
+    int nb = (N+bsize-1)/bsize;
+    int ns = (N+sbsize-1)/sbsize;
+    int *part;
+    MultilevelPartition(b_cind, b_rptr, &part, nb, ns, isSym);
+    // Inner blocks of each super-block
+    int *bptr = utils::SafeCalloc<int>(ns+1);
+    int *blist = utils::SafeMalloc<int>(nb);
+    for(int i=0; i<nb; i++) { bptr[part[i]+1]++; }
+    for(int s=0; s<ns; s++) { bptr[s+1] += bptr[s]; }
+    for(int i=0; i<nb; i++) { blist[bptr[part[i]]] = i; bptr[part[i]]++; }
+    for(int s=ns; s>0; s--) { bptr[s] = bptr[s-1]; }
+    bptr[0] = 0;
+    // Graph of the super-blocks
+    int *am_cind;
+    int *am_rptr;
+    GetAdjacency(b_cind, b_rptr, &am_cind, &am_rptr, nb, isSym);
+    int *s_cind = utils::SafeMalloc<int>(am_rptr[nb]);
+    int *s_rptr = utils::SafeMalloc<int>(ns+1);
+    int *mark = utils::SafeMalloc<int>(ns);
+    for(int s=0; s<ns; s++) { mark[s] = -1; }
     int cnt = 0;
-    for(int i=0; i<*num_color; i++) {
-        for(int j=0; j<N/bsize; j++) {
-            if(color[j]-1 != i) continue;
-            for(int k=0; k<bsize; k++) {
-                (*LP)[cnt] = block[j*bsize+k];
-                cnt++;
+    s_rptr[0] = 0;
+    for(int s=0; s<ns; s++) {
+        for(int k=bptr[s]; k<bptr[s+1]; k++) {
+            for(int j=am_rptr[blist[k]]; j<am_rptr[blist[k]+1]; j++) {
+                int t = part[am_cind[j]];
+                if(mark[t] == s) continue;
+                mark[t] = s;
+                s_cind[cnt] = t; cnt++;
+            }
+        }
+        s_rptr[s+1] = cnt;
+    }
+    int *color;
+    if(std::strcmp(cmethod, "greedy") == 0) {
+        Coloring(s_cind, s_rptr, &color, num_color, ns);
+    }else if(std::strcmp(cmethod, "parallel") == 0) {
+        ParallelColoring(s_cind, s_rptr, &color, num_color, ns);
+    }else if(std::strcmp(cmethod, "balanced") == 0) {
+        Coloring(s_cind, s_rptr, &color, num_color, ns);
+        BalanceColoring(s_cind, s_rptr, color, num_color, ns, min_size);
+    }else {
+        printf("Error: GetHABMCPermutation\n");
+        printf("The coloring method is invalid\n");
+        exit(1);
+    }
+    // The last inner block may be smaller, so its super-block is ordered
+    // last (with the inner block last in it).
+    int last = part[nb-1];
+    if(N%bsize) {
+        int c = color[last];
+        for(int s=0; s<ns; s++) {
+            if(color[s] == c) color[s] = *num_color;
+            else if(color[s] == *num_color) color[s] = c;
+        }
+    }
+    *size_color = utils::SafeCalloc<int>(*num_color+1);
+    for(int s=0; s<ns; s++) { (*size_color)[color[s]]++; }
+    for(int i=0; i<*num_color; i++) { (*size_color)[i+1] += (*size_color)[i]; }
+    int *pos = utils::SafeMalloc<int>(*num_color);
+    int *order = utils::SafeMalloc<int>(ns);
+    for(int i=0; i<*num_color; i++) { pos[i] = (*size_color)[i]; }
+    for(int s=0; s<ns; s++) {
+        if(N%bsize && s == last) continue;
+        order[pos[color[s]-1]] = s;
+        pos[color[s]-1]++;
+    }
+    if(N%bsize) order[ns-1] = last;
+    *LP = utils::SafeMalloc<int>(N);
+    *sptr = utils::SafeMalloc<int>(ns+1);
+    cnt = 0;
+    for(int i=0; i<ns; i++) {
+        int s = order[i];
+        (*sptr)[i] = cnt;
+        for(int k=bptr[s]; k<bptr[s+1]; k++) {
+            for(int l=0; l<bsize && blist[k]*bsize+l<N; l++) {
+                (*LP)[cnt] = block[blist[k]*bsize+l]; cnt++;
             }
         }
-        (*size_color)[i+1] = cnt/bsize;
     }
+    (*sptr)[ns] = cnt;
     *RP = utils::SafeMalloc<int>(N);
     for(int i=0; i<N; i++) {(*RP)[(*LP)[i]] = i;}
+    free(b_cind);
+    free(b_rptr);
+    free(block);
+    free(part);
+    free(bptr);
+    free(blist);
+    free(am_cind);
+    free(am_rptr);
+    free(s_cind);
+    free(s_rptr);
+    free(mark);
+    free(color);
+    free(pos);
+    free(order);
 }
 
 
@@ -7,6 +7,10 @@
 #ifndef SENK_HELPER_HPP
 #define SENK_HELPER_HPP
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace senk {
 /**
  * @brief Contains supplemental functions.
@@ -187,6 +191,127 @@ void QuickSortDesc(T *key, T2 *sub, T3 *sub2, int left, int right)
     if (left < Left-1) QuickSortDesc<T, T2, T3>(key, sub, sub2, left, Left-1);
     if (Right+1 < right) QuickSortDesc<T, T2, T3>(key, sub, sub2, Right+1, right);
 }
+/**
+ * @brief Insert a value into a binary min-heap.
+ * @tparam T Type of the values.
+ * @param heap An array that stores the heap.
+ * @param len The number of values in the heap, which is incremented.
+ * @param v The value to be inserted.
+ */
+template <typename T>
+void HeapPush(T *heap, int *len, T v)
+{
+    int i = len[0]++;
+    while(i > 0 && v < heap[(i-1)/2]) {
+        heap[i] = heap[(i-1)/2];
+        i = (i-1) / 2;
+    }
+    heap[i] = v;
+}
+/**
+ * @brief Remove the smallest value from a binary min-heap.
+ * @tparam T Type of the values.
+ * @param heap An array that stores the heap.
+ * @param len The number of values in the heap (at least 1), which is decremented.
+ * @return The smallest value.
+ */
+template <typename T>
+T HeapPop(T *heap, int *len)
+{
+    T top = heap[0];
+    T v = heap[--len[0]];
+    int i = 0;
+    while(true) {
+        int c = 2*i+1;
+        if(c >= len[0]) break;
+        if(c+1 < len[0] && heap[c+1] < heap[c]) c++;
+        if(!(heap[c] < v)) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if(len[0] > 0) heap[i] = v;
+    return top;
+}
+/**
+ * @brief Return the number of threads in the current team.
+ */
+inline int NumThreads()
+{
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+/**
+ * @brief Return the thread number of the calling thread.
+ */
+inline int ThreadId()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+/**
+ * @brief Return the maximum number of threads of a parallel region.
+ */
+inline int MaxThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+/**
+ * @brief Get the part of [0, N) assigned to the calling thread by static partitioning.
+ * @param N The size of the range.
+ * @param start A variable to receive the starting index.
+ * @param end A variable to receive the end index (exclusive).
+ */
+inline void ThreadRange(int N, int *start, int *end)
+{
+    int nt = NumThreads();
+    int tid = ThreadId();
+    int q = N / nt;
+    int r = N % nt;
+    start[0] = tid * q + ((tid < r) ? tid : r);
+    end[0] = start[0] + q + ((tid < r) ? 1 : 0);
+}
+/**
+ * @brief Compute the prefix sum ptr[i+1] += ptr[i] for i = 0, ..., N-1 in parallel.
+ * @details This function must be called by all threads of an enclosing
+ * parallel region. Each thread sums its static part of the array (see
+ * ThreadRange), and the partial sums are combined by a single thread.
+ * ptr[0] is the initial value.
+ * @param ptr A 1D-array of size N+1.
+ * @param N The number of sums.
+ * @param work A shared 1D-array of size (the number of threads)+1.
+ */
+inline void PrefixSum(int *ptr, int N, int *work)
+{
+    int nt = NumThreads();
+    int tid = ThreadId();
+    int start, end;
+    ThreadRange(N, &start, &end);
+    int sum = 0;
+    for(int i=start; i<end; i++) { sum += ptr[i+1]; }
+    work[tid+1] = sum;
+    #pragma omp barrier
+    #pragma omp single
+    {
+        work[0] = ptr[0];
+        for(int t=0; t<nt; t++) { work[t+1] += work[t]; }
+    }
+    sum = work[tid];
+    for(int i=start; i<end; i++) {
+        sum += ptr[i+1];
+        ptr[i+1] = sum;
+    }
+    #pragma omp barrier
+}
 /*
 template <typename T>
 T Sqrt(T x)
@@ -0,0 +1,619 @@
+/**
+ * @file senk_idrs.hpp
+ * @brief The IDR(s) solvers are defined.
+ * @author Kengo Suzuki
+ * @date 5/9/2022
+ */
+#ifndef SENK_IDRS_HPP
+#define SENK_IDRS_HPP
+
+#include <cmath>
+#include <random>
+
+#include "senk_sparse.hpp"
+#include "senk_blas1.hpp"
+#include "senk_utils.hpp"
+
+namespace senk {
+
+namespace solver {
+/**
+ * @brief Non-preconditioned IDR(s) solver
+ * @details The biorthogonal variant of IDR(s) by van Gijzen and Sonneveld is implemented.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations (matrix-vector products).
+ * @param s The dimension of the shadow space.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void Idrs(
+    T *val, int *cind, int *rptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int s, int N, T epsilon)
+{
+    T *r = new T[N];
+    T *v = new T[N];
+    T *t = new T[N];
+    T *P = new T[N*s];
+    T *G = new T[N*s];
+    T *U = new T[N*s];
+    T *red = new T[helper::MaxThreads()*s];
+    utils::Set<T>(0, G, N*s);
+    utils::Set<T>(0, U, N*s);
+
+    #pragma omp parallel
+    {
+        int iter = 0;
+        T *M = new T[s*s];
+        T *f = new T[s];
+        T *c = new T[s];
+        T alpha, beta, omega = 1;
+        T nrm_r;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+        // The shadow space is spanned by orthonormalized random vectors.
+        #pragma omp single
+        {
+            std::mt19937 engine(1);
+            std::uniform_real_distribution<T> dist(-1.0, 1.0);
+            for(int i=0; i<N*s; i++) { P[i] = dist(engine); }
+        }
+        for(int k=0; k<s; k++) {
+            for(int i=0; i<k; i++) {
+                alpha = blas1::orphan::Dot<T>(&P[i*N], &P[k*N], red, N);
+                blas1::orphan::Axpy<T>(-alpha, &P[i*N], &P[k*N], N);
+            }
+            blas1::orphan::Scal<T>(1/blas1::orphan::Nrm2<T>(&P[k*N], red, N), &P[k*N], N);
+        }
+        for(int i=0; i<s*s; i++) { M[i] = (i%(s+1) == 0) ? 1 : 0; }
+        while(nrm_r >= epsilon * nrm_b && iter < max_iter) {
+            blas1::orphan::Mdot<T>(P, r, f, red, s, N);
+            for(int k=0; k<s; k++) {
+                // Solve the lower triangular system M(k:s,k:s) c = f(k:s)
+                for(int i=k; i<s; i++) {
+                    T temp = f[i];
+                    for(int j=k; j<i; j++) { temp -= M[j*s+i] * c[j]; }
+                    c[i] = temp / M[i*s+i];
+                }
+                blas1::orphan::Copy<T>(r, v, N);
+                for(int i=k; i<s; i++) {
+                    blas1::orphan::Axpy<T>(-c[i], &G[i*N], v, N);
+                }
+                blas1::orphan::Axpby<T>(omega, v, c[k], &U[k*N], N);
+                for(int i=k+1; i<s; i++) {
+                    blas1::orphan::Axpy<T>(c[i], &U[i*N], &U[k*N], N);
+                }
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &U[k*N], &G[k*N], N);
+                // Make G(:,k) orthogonal to P(:,0:k-1)
+                for(int i=0; i<k; i++) {
+                    alpha = blas1::orphan::Dot<T>(&P[i*N], &G[k*N], red, N) / M[i*s+i];
+                    blas1::orphan::Axpy<T>(-alpha, &G[i*N], &G[k*N], N);
+                    blas1::orphan::Axpy<T>(-alpha, &U[i*N], &U[k*N], N);
+                }
+                blas1::orphan::Mdot<T>(&P[k*N], &G[k*N], &M[k*s+k], red, s-k, N);
+                beta = f[k] / M[k*s+k];
+                blas1::orphan::Axpy<T>(-beta, &G[k*N], r, N);
+                blas1::orphan::Axpy<T>(beta, &U[k*N], x, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                iter++;
+#if PRINT_RES
+                #pragma omp master
+                printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+                if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+                for(int i=k+1; i<s; i++) { f[i] -= beta * M[k*s+i]; }
+            }
+            if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+            // Enter the next Sonneveld space
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, r, t, N);
+            T nrm_t = blas1::orphan::Nrm2<T>(t, red, N);
+            T tr = blas1::orphan::Dot<T>(t, r, red, N);
+            omega = tr / (nrm_t * nrm_t);
+            // Maintain the convergence by limiting the angle between t and r
+            T rho = std::abs(tr) / (nrm_t * nrm_r);
+            if(rho < 0.7) { omega *= 0.7 / rho; }
+            blas1::orphan::Axpy<T>(omega, r, x, N);
+            blas1::orphan::Axpy<T>(-omega, t, r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            iter++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+        }
+        if(nrm_r < epsilon * nrm_b) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] M;
+        delete[] f;
+        delete[] c;
+    }
+    delete[] r;
+    delete[] v;
+    delete[] t;
+    delete[] P;
+    delete[] G;
+    delete[] U;
+    delete[] red;
+}
+/**
+ * @brief ILU preconditioned IDR(s) solver
+ * @details The biorthogonal variant of IDR(s) by van Gijzen and Sonneveld is implemented.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param lval Same as val, but for the matrix L.
+ * @param lcind Same as cind, but for the matrix L.
+ * @param lrptr Same as rptr, but for the matrix L.
+ * @param uval Same as val, but for the matrix U.
+ * @param ucind Same as cind, but for the matrix U.
+ * @param urptr Same as rptr, but for the matrix U.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations (matrix-vector products).
+ * @param s The dimension of the shadow space.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void IluIdrs(
+    T *val, int *cind, int *rptr,
+    T *lval, int *lcind, int *lrptr,
+    T *uval, int *ucind, int *urptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int s, int N, T epsilon)
+{
+    T *r = new T[N];
+    T *v = new T[N];
+    T *t = new T[N];
+    T *P = new T[N*s];
+    T *G = new T[N*s];
+    T *U = new T[N*s];
+    T *red = new T[helper::MaxThreads()*s];
+    utils::Set<T>(0, G, N*s);
+    utils::Set<T>(0, U, N*s);
+
+    #pragma omp parallel
+    {
+        int iter = 0;
+        T *M = new T[s*s];
+        T *f = new T[s];
+        T *c = new T[s];
+        T alpha, beta, omega = 1;
+        T nrm_r;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+        // The shadow space is spanned by orthonormalized random vectors.
+        #pragma omp single
+        {
+            std::mt19937 engine(1);
+            std::uniform_real_distribution<T> dist(-1.0, 1.0);
+            for(int i=0; i<N*s; i++) { P[i] = dist(engine); }
+        }
+        for(int k=0; k<s; k++) {
+            for(int i=0; i<k; i++) {
+                alpha = blas1::orphan::Dot<T>(&P[i*N], &P[k*N], red, N);
+                blas1::orphan::Axpy<T>(-alpha, &P[i*N], &P[k*N], N);
+            }
+            blas1::orphan::Scal<T>(1/blas1::orphan::Nrm2<T>(&P[k*N], red, N), &P[k*N], N);
+        }
+        for(int i=0; i<s*s; i++) { M[i] = (i%(s+1) == 0) ? 1 : 0; }
+        while(nrm_r >= epsilon * nrm_b && iter < max_iter) {
+            blas1::orphan::Mdot<T>(P, r, f, red, s, N);
+            for(int k=0; k<s; k++) {
+                // Solve the lower triangular system M(k:s,k:s) c = f(k:s)
+                for(int i=k; i<s; i++) {
+                    T temp = f[i];
+                    for(int j=k; j<i; j++) { temp -= M[j*s+i] * c[j]; }
+                    c[i] = temp / M[i*s+i];
+                }
+                blas1::orphan::Copy<T>(r, v, N);
+                for(int i=k; i<s; i++) {
+                    blas1::orphan::Axpy<T>(-c[i], &G[i*N], v, N);
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, v, t, N);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N);
+                blas1::orphan::Axpby<T>(omega, t, c[k], &U[k*N], N);
+                for(int i=k+1; i<s; i++) {
+                    blas1::orphan::Axpy<T>(c[i], &U[i*N], &U[k*N], N);
+                }
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &U[k*N], &G[k*N], N);
+                // Make G(:,k) orthogonal to P(:,0:k-1)
+                for(int i=0; i<k; i++) {
+                    alpha = blas1::orphan::Dot<T>(&P[i*N], &G[k*N], red, N) / M[i*s+i];
+                    blas1::orphan::Axpy<T>(-alpha, &G[i*N], &G[k*N], N);
+                    blas1::orphan::Axpy<T>(-alpha, &U[i*N], &U[k*N], N);
+                }
+                blas1::orphan::Mdot<T>(&P[k*N], &G[k*N], &M[k*s+k], red, s-k, N);
+                beta = f[k] / M[k*s+k];
+                blas1::orphan::Axpy<T>(-beta, &G[k*N], r, N);
+                blas1::orphan::Axpy<T>(beta, &U[k*N], x, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                iter++;
+#if PRINT_RES
+                #pragma omp master
+                printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+                if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+                for(int i=k+1; i<s; i++) { f[i] -= beta * M[k*s+i]; }
+            }
+            if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+            // Enter the next Sonneveld space
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, r, v, N);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, v, v, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, v, t, N);
+            T nrm_t = blas1::orphan::Nrm2<T>(t, red, N);
+            T tr = blas1::orphan::Dot<T>(t, r, red, N);
+            omega = tr / (nrm_t * nrm_t);
+            // Maintain the convergence by limiting the angle between t and r
+            T rho = std::abs(tr) / (nrm_t * nrm_r);
+            if(rho < 0.7) { omega *= 0.7 / rho; }
+            blas1::orphan::Axpy<T>(omega, v, x, N);
+            blas1::orphan::Axpy<T>(-omega, t, r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            iter++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+        }
+        if(nrm_r < epsilon * nrm_b) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] M;
+        delete[] f;
+        delete[] c;
+    }
+    delete[] r;
+    delete[] v;
+    delete[] t;
+    delete[] P;
+    delete[] G;
+    delete[] U;
+    delete[] red;
+}
+/**
+ * @brief ILU preconditioned IDR(s) solver parallelized by ABMC ordering
+ * @details The biorthogonal variant of IDR(s) by van Gijzen and Sonneveld is implemented.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param lval Same as val, but for the matrix L.
+ * @param lcind Same as cind, but for the matrix L.
+ * @param lrptr Same as rptr, but for the matrix L.
+ * @param uval Same as val, but for the matrix U.
+ * @param ucind Same as cind, but for the matrix U.
+ * @param urptr Same as rptr, but for the matrix U.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ * @param bsize The number of rows/columns of the blocks used in ABMC.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations (matrix-vector products).
+ * @param s The dimension of the shadow space.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T>
+void AbmcIluIdrs(
+    T *val, int *cind, int *rptr,
+    T *lval, int *lcind, int *lrptr,
+    T *uval, int *ucind, int *urptr,
+    int *cptr, int cnum, int bsize,
+    T *b, T *x, T nrm_b,
+    int max_iter, int s, int N, T epsilon)
+{
+    T *r = new T[N];
+    T *v = new T[N];
+    T *t = new T[N];
+    T *P = new T[N*s];
+    T *G = new T[N*s];
+    T *U = new T[N*s];
+    T *red = new T[helper::MaxThreads()*s];
+    utils::Set<T>(0, G, N*s);
+    utils::Set<T>(0, U, N*s);
+
+    #pragma omp parallel
+    {
+        int iter = 0;
+        T *M = new T[s*s];
+        T *f = new T[s];
+        T *c = new T[s];
+        T alpha, beta, omega = 1;
+        T nrm_r;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+        // The shadow space is spanned by orthonormalized random vectors.
+        #pragma omp single
+        {
+            std::mt19937 engine(1);
+            std::uniform_real_distribution<T> dist(-1.0, 1.0);
+            for(int i=0; i<N*s; i++) { P[i] = dist(engine); }
+        }
+        for(int k=0; k<s; k++) {
+            for(int i=0; i<k; i++) {
+                alpha = blas1::orphan::Dot<T>(&P[i*N], &P[k*N], red, N);
+                blas1::orphan::Axpy<T>(-alpha, &P[i*N], &P[k*N], N);
+            }
+            blas1::orphan::Scal<T>(1/blas1::orphan::Nrm2<T>(&P[k*N], red, N), &P[k*N], N);
+        }
+        for(int i=0; i<s*s; i++) { M[i] = (i%(s+1) == 0) ? 1 : 0; }
+        while(nrm_r >= epsilon * nrm_b && iter < max_iter) {
+            blas1::orphan::Mdot<T>(P, r, f, red, s, N);
+            for(int k=0; k<s; k++) {
+                // Solve the lower triangular system M(k:s,k:s) c = f(k:s)
+                for(int i=k; i<s; i++) {
+                    T temp = f[i];
+                    for(int j=k; j<i; j++) { temp -= M[j*s+i] * c[j]; }
+                    c[i] = temp / M[i*s+i];
+                }
+                blas1::orphan::Copy<T>(r, v, N);
+                for(int i=k; i<s; i++) {
+                    blas1::orphan::Axpy<T>(-c[i], &G[i*N], v, N);
+                }
+                sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, v, t, N, cptr, cnum, bsize);
+                sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, t, t, N, cptr, cnum, bsize);
+                blas1::orphan::Axpby<T>(omega, t, c[k], &U[k*N], N);
+                for(int i=k+1; i<s; i++) {
+                    blas1::orphan::Axpy<T>(c[i], &U[i*N], &U[k*N], N);
+                }
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &U[k*N], &G[k*N], N);
+                // Make G(:,k) orthogonal to P(:,0:k-1)
+                for(int i=0; i<k; i++) {
+                    alpha = blas1::orphan::Dot<T>(&P[i*N], &G[k*N], red, N) / M[i*s+i];
+                    blas1::orphan::Axpy<T>(-alpha, &G[i*N], &G[k*N], N);
+                    blas1::orphan::Axpy<T>(-alpha, &U[i*N], &U[k*N], N);
+                }
+                blas1::orphan::Mdot<T>(&P[k*N], &G[k*N], &M[k*s+k], red, s-k, N);
+                beta = f[k] / M[k*s+k];
+                blas1::orphan::Axpy<T>(-beta, &G[k*N], r, N);
+                blas1::orphan::Axpy<T>(beta, &U[k*N], x, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                iter++;
+#if PRINT_RES
+                #pragma omp master
+                printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+                if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+                for(int i=k+1; i<s; i++) { f[i] -= beta * M[k*s+i]; }
+            }
+            if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+            // Enter the next Sonneveld space
+            sparse::orphan::SptrsvCsr_l<T>(lval, lcind, lrptr, r, v, N, cptr, cnum, bsize);
+            sparse::orphan::SptrsvCsr_u<T>(uval, ucind, urptr, v, v, N, cptr, cnum, bsize);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, v, t, N);
+            T nrm_t = blas1::orphan::Nrm2<T>(t, red, N);
+            T tr = blas1::orphan::Dot<T>(t, r, red, N);
+            omega = tr / (nrm_t * nrm_t);
+            // Maintain the convergence by limiting the angle between t and r
+            T rho = std::abs(tr) / (nrm_t * nrm_r);
+            if(rho < 0.7) { omega *= 0.7 / rho; }
+            blas1::orphan::Axpy<T>(omega, v, x, N);
+            blas1::orphan::Axpy<T>(-omega, t, r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            iter++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+        }
+        if(nrm_r < epsilon * nrm_b) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] M;
+        delete[] f;
+        delete[] c;
+    }
+    delete[] r;
+    delete[] v;
+    delete[] t;
+    delete[] P;
+    delete[] G;
+    delete[] U;
+    delete[] red;
+}
+/**
+ * @brief ILUB preconditioned IDR(s) solver
+ * @details The biorthogonal variant of IDR(s) by van Gijzen and Sonneveld is implemented.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param val val array of the CSR storage format.
+ * @param cind col-index array of the CSR storage format.
+ * @param rptr row-ptr array of the CSR storage format.
+ * @param blval values of L in the BCSR format.
+ * @param blcind colum positions of blocks of L in the BCSR format.
+ * @param blrptr starting positions of row blocks of L in the BCSR format.
+ * @param buval values of U in the BCSR format.
+ * @param bucind colum positions of blocks of U in the BCSR format.
+ * @param burptr starting positions of row blocks of U in the BCSR format.
+ * @param b The right-hand side vector.
+ * @param x The unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param max_iter The maximum number of iterations (matrix-vector products).
+ * @param s The dimension of the shadow space.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, int bnl, int bnw>
+void IlubIdrs(
+    T *val, int *cind, int *rptr,
+    T *blval, int *blcind, int *blrptr,
+    T *buval, int *bucind, int *burptr,
+    T *b, T *x, T nrm_b,
+    int max_iter, int s, int N, T epsilon)
+{
+    T *r = new T[N];
+    T *v = new T[N];
+    T *t = new T[N];
+    T *P = new T[N*s];
+    T *G = new T[N*s];
+    T *U = new T[N*s];
+    T *red = new T[helper::MaxThreads()*s];
+    utils::Set<T>(0, G, N*s);
+    utils::Set<T>(0, U, N*s);
+
+    #pragma omp parallel
+    {
+        int iter = 0;
+        T *M = new T[s*s];
+        T *f = new T[s];
+        T *c = new T[s];
+        T alpha, beta, omega = 1;
+        T nrm_r;
+
+        sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, r, N);
+        blas1::orphan::Axpby<T>(1, b, -1, r, N);
+        nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+        // The shadow space is spanned by orthonormalized random vectors.
+        #pragma omp single
+        {
+            std::mt19937 engine(1);
+            std::uniform_real_distribution<T> dist(-1.0, 1.0);
+            for(int i=0; i<N*s; i++) { P[i] = dist(engine); }
+        }
+        for(int k=0; k<s; k++) {
+            for(int i=0; i<k; i++) {
+                alpha = blas1::orphan::Dot<T>(&P[i*N], &P[k*N], red, N);
+                blas1::orphan::Axpy<T>(-alpha, &P[i*N], &P[k*N], N);
+            }
+            blas1::orphan::Scal<T>(1/blas1::orphan::Nrm2<T>(&P[k*N], red, N), &P[k*N], N);
+        }
+        for(int i=0; i<s*s; i++) { M[i] = (i%(s+1) == 0) ? 1 : 0; }
+        while(nrm_r >= epsilon * nrm_b && iter < max_iter) {
+            blas1::orphan::Mdot<T>(P, r, f, red, s, N);
+            for(int k=0; k<s; k++) {
+                // Solve the lower triangular system M(k:s,k:s) c = f(k:s)
+                for(int i=k; i<s; i++) {
+                    T temp = f[i];
+                    for(int j=k; j<i; j++) { temp -= M[j*s+i] * c[j]; }
+                    c[i] = temp / M[i*s+i];
+                }
+                blas1::orphan::Copy<T>(r, v, N);
+                for(int i=k; i<s; i++) {
+                    blas1::orphan::Axpy<T>(-c[i], &G[i*N], v, N);
+                }
+                sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, v, t, N);
+                sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, t, t, N);
+                blas1::orphan::Axpby<T>(omega, t, c[k], &U[k*N], N);
+                for(int i=k+1; i<s; i++) {
+                    blas1::orphan::Axpy<T>(c[i], &U[i*N], &U[k*N], N);
+                }
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, &U[k*N], &G[k*N], N);
+                // Make G(:,k) orthogonal to P(:,0:k-1)
+                for(int i=0; i<k; i++) {
+                    alpha = blas1::orphan::Dot<T>(&P[i*N], &G[k*N], red, N) / M[i*s+i];
+                    blas1::orphan::Axpy<T>(-alpha, &G[i*N], &G[k*N], N);
+                    blas1::orphan::Axpy<T>(-alpha, &U[i*N], &U[k*N], N);
+                }
+                blas1::orphan::Mdot<T>(&P[k*N], &G[k*N], &M[k*s+k], red, s-k, N);
+                beta = f[k] / M[k*s+k];
+                blas1::orphan::Axpy<T>(-beta, &G[k*N], r, N);
+                blas1::orphan::Axpy<T>(beta, &U[k*N], x, N);
+                nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+                iter++;
+#if PRINT_RES
+                #pragma omp master
+                printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+                if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+                for(int i=k+1; i<s; i++) { f[i] -= beta * M[k*s+i]; }
+            }
+            if(nrm_r < epsilon * nrm_b || iter == max_iter) break;
+            // Enter the next Sonneveld space
+            sparse::orphan::SptrsvBcsr_l<T, bnl, bnw>(blval, blcind, blrptr, r, v, N);
+            sparse::orphan::SptrsvBcsr_u<T, bnl, bnw>(buval, bucind, burptr, v, v, N);
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, v, t, N);
+            T nrm_t = blas1::orphan::Nrm2<T>(t, red, N);
+            T tr = blas1::orphan::Dot<T>(t, r, red, N);
+            omega = tr / (nrm_t * nrm_t);
+            // Maintain the convergence by limiting the angle between t and r
+            T rho = std::abs(tr) / (nrm_t * nrm_r);
+            if(rho < 0.7) { omega *= 0.7 / rho; }
+            blas1::orphan::Axpy<T>(omega, v, x, N);
+            blas1::orphan::Axpy<T>(-omega, t, r, N);
+            nrm_r = blas1::orphan::Nrm2<T>(r, red, N);
+            iter++;
+#if PRINT_RES
+            #pragma omp master
+            printf("%s %d %e\n", RES_SYMBOL, iter, nrm_r/nrm_b);
+#endif
+        }
+        if(nrm_r < epsilon * nrm_b) {
+            #pragma omp master
+            {
+                printf("%s iter %d\n", ITER_SYMBOL, iter);
+                printf("%s res %e\n", RES_SYMBOL, nrm_r/nrm_b);
+            }
+        }else {
+            #pragma omp master
+            {
+                printf("# iter %d (max)\n", iter);
+                printf("# res %e\n", nrm_r/nrm_b);
+            }
+        }
+        delete[] M;
+        delete[] f;
+        delete[] c;
+    }
+    delete[] r;
+    delete[] v;
+    delete[] t;
+    delete[] P;
+    delete[] G;
+    delete[] U;
+    delete[] red;
+}
+
+} // namespace solver
+
+} // namespace senk
+
+#endif
@@ -9,9 +9,12 @@
 
 #include <cstdio>
 #include <cstring>
+#include <cmath>
+#include <limits>
 
 #include "senk_utils.hpp"
 #include "senk_class.hpp"
+#include "senk_blas2.hpp"
 
 namespace senk {
 /**
@@ -66,25 +69,153 @@ void Csr2Csc(
     *cval  = utils::SafeMalloc<T>(nnz);
     *crind = utils::SafeMalloc<int>(nnz);
     *ccptr = utils::SafeMalloc<int>(M+1);
-    int *num = utils::SafeCalloc<int>(M);
-    for(int i=0; i<N; i++) {
-        for(int j=rptr[i]; j<rptr[i+1]; j++) { num[cind[j]]++; }
-    }
+    // Each thread counts the columns of its static range of rows, so that
+    // the rows of each column are stored in increasing order.
+    int nt = helper::MaxThreads();
+    int *num = utils::SafeMalloc<int>(nt*M);
+    int *work = utils::SafeMalloc<int>(nt+1);
     (*ccptr)[0] = 0;
-    for(int i=0; i<M; i++) {
-        (*ccptr)[i+1] = (*ccptr)[i] + num[i];
-        num[i] = 0;
-    }
-    for(int i=0; i<N; i++) {
-        for(int j=rptr[i]; j<rptr[i+1]; j++) {
-            int off = (*ccptr)[cind[j]];
-            int pos = num[cind[j]];
-            (*crind)[off+pos] = i;
-            (*cval)[off+pos] = val[j];
-            num[cind[j]]++;
+    #pragma omp parallel
+    {
+        int tnum = helper::NumThreads();
+        int *cnt = &num[helper::ThreadId()*M];
+        int start, end;
+        helper::ThreadRange(N, &start, &end);
+        for(int i=0; i<M; i++) { cnt[i] = 0; }
+        for(int i=start; i<end; i++) {
+            for(int j=rptr[i]; j<rptr[i+1]; j++) { cnt[cind[j]]++; }
+        }
+        #pragma omp barrier
+        #pragma omp for
+        for(int i=0; i<M; i++) {
+            int sum = 0;
+            for(int t=0; t<tnum; t++) {
+                int temp = num[t*M+i];
+                num[t*M+i] = sum;
+                sum += temp;
+            }
+            (*ccptr)[i+1] = sum;
+        }
+        helper::PrefixSum(*ccptr, M, work);
+        for(int i=start; i<end; i++) {
+            for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                int pos = (*ccptr)[cind[j]] + cnt[cind[j]];
+                (*crind)[pos] = i;
+                (*cval)[pos] = val[j];
+                cnt[cind[j]]++;
+            }
         }
     }
     free(num);
+    free(work);
+}
+
+inline void SpGemmSymbolic(
+    int *acind, int *arptr,
+    int *bcind, int *brptr,
+    int **ccind, int **crptr,
+    int N, int M)
+{
+    // The pattern of C = A * B, where A is N * K and B is K * M.
+    *crptr = utils::SafeMalloc<int>(N+1);
+    (*crptr)[0] = 0;
+    #pragma omp parallel
+    {
+        int *mark = utils::SafeMalloc<int>(M);
+        for(int i=0; i<M; i++) { mark[i] = -1; }
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int cnt = 0;
+            for(int j=arptr[i]; j<arptr[i+1]; j++) {
+                int k = acind[j];
+                for(int l=brptr[k]; l<brptr[k+1]; l++) {
+                    if(mark[bcind[l]] != i) { mark[bcind[l]] = i; cnt++; }
+                }
+            }
+            (*crptr)[i+1] = cnt;
+        }
+        #pragma omp single
+        {
+            for(int i=0; i<N; i++) { (*crptr)[i+1] += (*crptr)[i]; }
+            *ccind = utils::SafeMalloc<int>((*crptr)[N]);
+        }
+        for(int i=0; i<M; i++) { mark[i] = -1; }
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int pos = (*crptr)[i];
+            for(int j=arptr[i]; j<arptr[i+1]; j++) {
+                int k = acind[j];
+                for(int l=brptr[k]; l<brptr[k+1]; l++) {
+                    if(mark[bcind[l]] != i) { mark[bcind[l]] = i; (*ccind)[pos] = bcind[l]; pos++; }
+                }
+            }
+            if(pos - (*crptr)[i] > 1) helper::QuickSort<int>(*ccind, (*crptr)[i], pos-1);
+        }
+        free(mark);
+    }
+}
+
+template <typename T>
+void SpGemmNumeric(
+    T *aval, int *acind, int *arptr,
+    T *bval, int *bcind, int *brptr,
+    T *cval, int *ccind, int *crptr,
+    int N, int M)
+{
+    // The values of C = A * B on the pattern given by SpGemmSymbolic, which
+    // can be reused as long as the patterns of A and B do not change.
+    #pragma omp parallel
+    {
+        T *acc = utils::SafeCalloc<T>(M);
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            for(int j=arptr[i]; j<arptr[i+1]; j++) {
+                int k = acind[j];
+                T a = aval[j];
+                for(int l=brptr[k]; l<brptr[k+1]; l++) {
+                    acc[bcind[l]] += a * bval[l];
+                }
+            }
+            for(int j=crptr[i]; j<crptr[i+1]; j++) {
+                cval[j] = acc[ccind[j]];
+                acc[ccind[j]] = 0;
+            }
+        }
+        free(acc);
+    }
+}
+
+template <typename T>
+void SpGemm(
+    T *aval, int *acind, int *arptr,
+    T *bval, int *bcind, int *brptr,
+    T **cval, int **ccind, int **crptr,
+    int N, int M)
+{
+    // C = A * B, where A is N * K and B is K * M.
+    SpGemmSymbolic(acind, arptr, bcind, brptr, ccind, crptr, N, M);
+    *cval = utils::SafeMalloc<T>((*crptr)[N]);
+    SpGemmNumeric<T>(aval, acind, arptr, bval, bcind, brptr, *cval, *ccind, *crptr, N, M);
+}
+
+inline void PowerPattern(
+    int *cind, int *rptr,
+    int **pcind, int **prptr,
+    int N, int k)
+{
+    // The pattern of A^k
+    *prptr = utils::SafeMalloc<int>(N+1);
+    *pcind = utils::SafeMalloc<int>(rptr[N]);
+    utils::Copy<int>(rptr, *prptr, N+1);
+    utils::Copy<int>(cind, *pcind, rptr[N]);
+    for(int p=1; p<k; p++) {
+        int *tcind, *trptr;
+        SpGemmSymbolic(*pcind, *prptr, cind, rptr, &tcind, &trptr, N, N);
+        free(*pcind);
+        free(*prptr);
+        *pcind = tcind;
+        *prptr = trptr;
+    }
 }
 
 template <typename T>
@@ -147,67 +278,69 @@ void Csr2Bcsr(
     T **bval, int **bcind, int **brptr,
     int N, int bnl, int bnw)
 {
-    if(N % bnl || N % bnw) {
-        printf("Error: Csr2Bcsr\n");
-        exit(EXIT_FAILURE);
-    }
-    *brptr = utils::SafeMalloc<int>(N/bnl+1);
-    int cnt = 0;
+    // When N is not a multiple of bnl (bnw), the last block row (column) is
+    // padded with zero rows (columns).
+    int nb = (N+bnl-1) / bnl;
+    *brptr = utils::SafeMalloc<int>(nb+1);
     (*brptr)[0] = 0;
-    int *ptr = utils::SafeMalloc<int>(bnl);
+    int *work = utils::SafeMalloc<int>(helper::MaxThreads()+1);
+    #pragma omp parallel
+    {
+        int *ptr = utils::SafeMalloc<int>(bnl);
 // Count the number of block
-    for(int i=0; i<N; i+=bnl) {
-        // Initialize "ptr"
-        for(int j=0; j<bnl; j++) { ptr[j] = rptr[i+j]; }
-        while(true) {
-            // Find minimum col value
-            int min = N;
-            for(int j=0; j<bnl; j++) {
-                if(ptr[j] != -1 && cind[ptr[j]] < min)
-                    min = cind[ptr[j]];
-            }
-            if(min == N) break;
-            // Increment ptr[j] whose col-idx is in min block
-            for(int j=0; j<bnl; j++) {
-                if(ptr[j] == -1) continue;
-                while(cind[ptr[j]]/bnw == min/bnw) {
-                    ptr[j]++;
-                    if(ptr[j] >= rptr[i+j+1]) {ptr[j] = -1; break;}
+        int nbw = (N+bnw-1) / bnw;
+        int *mark = utils::SafeMalloc<int>(nbw);
+        for(int j=0; j<nbw; j++) { mark[j] = -1; }
+        #pragma omp for
+        for(int bi=0; bi<nb; bi++) {
+            int end = (bi*bnl+bnl < N) ? bi*bnl+bnl : N;
+            int cnt = 0;
+            for(int i=bi*bnl; i<end; i++) {
+                for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                    if(mark[cind[j]/bnw] != bi) { mark[cind[j]/bnw] = bi; cnt++; }
                 }
             }
-            cnt++;
+            (*brptr)[bi+1] = cnt;
+        }
+        free(mark);
+        helper::PrefixSum(*brptr, nb, work);
+        #pragma omp single
+        {
+            *bcind = utils::SafeMalloc<int>((*brptr)[nb]);
+            *bval  = utils::SafeCalloc<T>((*brptr)[nb]*bnl*bnw);
         }
-        (*brptr)[i/bnl+1] = cnt;
-    }
-    *bcind = utils::SafeMalloc<int>(cnt);
-    *bval  = utils::SafeCalloc<T>(cnt*bnl*bnw);
 // Assign val to bval
-    cnt = 0;
-    for(int i=0; i<N; i+=bnl) {
-        // Initialize "ptr"
-        for(int j=0; j<bnl; j++) { ptr[j] = rptr[i+j]; }
-        while(true) {
-            int min = N;
-            for(int j=0; j<bnl; j++) {
-                if(ptr[j] != -1 && cind[ptr[j]] < min)
-                    min = cind[ptr[j]];
-            }
-            if(min == N) break;
-            for(int j=0; j<bnl; j++) {
-                if(ptr[j] == -1) continue;
-                while(cind[ptr[j]]/bnw == min/bnw) {
-                    int off = cind[ptr[j]] % bnw;
-                    (*bval)[cnt*bnl*bnw+off*bnl+j] = val[ptr[j]];
-                    //printf("%e\n", (*bval)[cnt*bnl*bnw+off*bnl+j]);
-                    ptr[j]++;
-                    if(ptr[j] >= rptr[i+j+1]) {ptr[j] = -1; break;}
+        T *bv = *bval;
+        int *bc = *bcind;
+        #pragma omp for
+        for(int bi=0; bi<nb; bi++) {
+            int i = bi * bnl;
+            int cnt = (*brptr)[bi];
+            // Initialize "ptr"
+            for(int j=0; j<bnl; j++) { ptr[j] = (i+j < N && rptr[i+j] < rptr[i+j+1]) ? rptr[i+j] : -1; }
+            while(true) {
+                int min = N;
+                for(int j=0; j<bnl; j++) {
+                    if(ptr[j] != -1 && cind[ptr[j]] < min)
+                        min = cind[ptr[j]];
                 }
+                if(min == N) break;
+                for(int j=0; j<bnl; j++) {
+                    if(ptr[j] == -1) continue;
+                    while(cind[ptr[j]]/bnw == min/bnw) {
+                        int off = cind[ptr[j]] % bnw;
+                        bv[cnt*bnl*bnw+off*bnl+j] = val[ptr[j]];
+                        ptr[j]++;
+                        if(ptr[j] >= rptr[i+j+1]) {ptr[j] = -1; break;}
+                    }
+                }
+                bc[cnt] = min/bnw;
+                cnt++;
             }
-            (*bcind)[cnt] = min/bnw;
-            cnt++;
         }
+        free(ptr);
     }
-    free(ptr);
+    free(work);
 }
 
 template <typename T>
@@ -217,25 +350,44 @@ int Bcsr2Csr(
     int N, int bnl, int bnw)
 {
     int bsize = bnl * bnw;
-    int num_block = brptr[N/bnl];
+    int num_block = brptr[(N+bnl-1)/bnl];
     int nnz;
     *val = senk::utils::SafeMalloc<T>(num_block*bnl*bnw);
     *cind = senk::utils::SafeMalloc<int>(num_block*bnl*bnw);
     *rptr = senk::utils::SafeMalloc<int>(N+1);
     (*rptr)[0] = 0;
-    int count = 0;
-    for(int i=0; i<N; i++) {
-        int bid = i / bnl;
-        int id = i % bnl; // 0 to bnl-1
-        for(int bj=brptr[bid]; bj<brptr[bid+1]; bj++) {
-            for(int j=0; j<bnw; j++) {
-                (*cind)[count] = (bcind[bj])*bnw+j;
-                (*val)[count] = bval[bj*bsize+j*bnl+id];
-                count++;
+    int *work = utils::SafeMalloc<int>(helper::MaxThreads()+1);
+    T *v_ptr = *val;
+    int *c_ptr = *cind;
+    int *r_ptr = *rptr;
+    #pragma omp parallel
+    {
+        // All rows of a block row have the same length
+        #pragma omp for
+        for(int bid=0; bid<(N+bnl-1)/bnl; bid++) {
+            int count = 0;
+            for(int bj=brptr[bid]; bj<brptr[bid+1]; bj++) {
+                count += (N-bcind[bj]*bnw < bnw) ? N-bcind[bj]*bnw : bnw;
+            }
+            for(int i=bid*bnl; i<bid*bnl+bnl && i<N; i++) { r_ptr[i+1] = count; }
+        }
+        helper::PrefixSum(r_ptr, N, work);
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int bid = i / bnl;
+            int id = i % bnl; // 0 to bnl-1
+            int count = r_ptr[i];
+            for(int bj=brptr[bid]; bj<brptr[bid+1]; bj++) {
+                for(int j=0; j<bnw; j++) {
+                    if(bcind[bj]*bnw+j >= N) break;
+                    c_ptr[count] = (bcind[bj])*bnw+j;
+                    v_ptr[count] = bval[bj*bsize+j*bnl+id];
+                    count++;
+                }
             }
         }
-        (*rptr)[i+1] = count;
     }
+    free(work);
     nnz = (*rptr)[N];
     return nnz;
 }
@@ -261,59 +413,61 @@ void Split(
     T **uval, int **ucind, int **urptr,
     T **diag, int N, const char *key, bool invDiag)
 {
-    int lNNZ = 0;
-    int uNNZ = 0;
-    int dNNZ = 0;
-    int *l_ptr, *u_ptr, *d_ptr;
-    T *lv_ptr, *uv_ptr, *dv_ptr;
-    int *lc_ptr, *uc_ptr, *dc_ptr;
-    int *lr_ptr, *ur_ptr;
+    // The array (0: L, 1: U, 2: diag) that receives the lower, upper and
+    // diagonal elements
+    int dst[3];
     if(std::strcmp(key, "LD-U") == 0) {
-        l_ptr=&lNNZ; u_ptr=&uNNZ; d_ptr=&lNNZ;
+        dst[0] = 0; dst[1] = 1; dst[2] = 0;
     }else if(std::strcmp(key, "L-DU") == 0) {
-        l_ptr=&lNNZ; u_ptr=&uNNZ; d_ptr=&uNNZ;
+        dst[0] = 0; dst[1] = 1; dst[2] = 1;
     }else if(std::strcmp(key, "L-D-U") == 0) {
-        l_ptr=&lNNZ; u_ptr=&uNNZ; d_ptr=&dNNZ;
+        dst[0] = 0; dst[1] = 1; dst[2] = 2;
     }else if(std::strcmp(key, "LU-D") == 0) {
-        l_ptr=&lNNZ; u_ptr=&lNNZ; d_ptr=&dNNZ;
+        dst[0] = 0; dst[1] = 0; dst[2] = 2;
     }else { printf("Split: Keyword is not valid."); exit(1); }
-    for(int i=0; i<N; i++) {
-        for(int j=rptr[i]; j<rptr[i+1]; j++) {
-            if(cind[j] < i) { (*l_ptr)++; }
-            else if(cind[j] > i) { (*u_ptr)++; }
-            else { (*d_ptr)++; }
+    // Row pointers of L and U
+    *lrptr = utils::SafeMalloc<int>(N+1);
+    int *u_rptr = utils::SafeMalloc<int>(N+1);
+    int *work = utils::SafeMalloc<int>(helper::MaxThreads()+1);
+    int dNNZ = 0;
+    (*lrptr)[0] = 0;
+    u_rptr[0] = 0;
+    #pragma omp parallel reduction(+:dNNZ)
+    {
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int num[3] = {0, 0, 0};
+            for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                if(cind[j] < i) { num[dst[0]]++; }
+                else if(cind[j] > i) { num[dst[1]]++; }
+                else { num[dst[2]]++; }
+            }
+            (*lrptr)[i+1] = num[0];
+            u_rptr[i+1] = num[1];
+            dNNZ += num[2];
         }
+        helper::PrefixSum(*lrptr, N, work);
+        helper::PrefixSum(u_rptr, N, work);
     }
+    int lNNZ = (*lrptr)[N];
+    int uNNZ = u_rptr[N];
     *lval  = utils::SafeMalloc<T>(lNNZ);
     *lcind = utils::SafeMalloc<int>(lNNZ);
-    *lrptr = utils::SafeMalloc<int>(N+1);
     if(uNNZ != 0) {
         *uval  = utils::SafeMalloc<T>(uNNZ);
         *ucind = utils::SafeMalloc<int>(uNNZ);
-        *urptr = utils::SafeMalloc<int>(N+1);
+        *urptr = u_rptr;
     }
     if(dNNZ == N) { *diag = utils::SafeMalloc<T>(dNNZ); }
-    lNNZ = 0; uNNZ = 0; dNNZ = 0;
-    if(std::strcmp(key, "LD-U") == 0) {
-        lv_ptr = *lval;  uv_ptr = *uval;  dv_ptr = *lval;
-        lc_ptr = *lcind; uc_ptr = *ucind; dc_ptr = *lcind;
-        lr_ptr = *lrptr; ur_ptr = *urptr;
-    }else if(std::strcmp(key, "L-DU") == 0) {
-        lv_ptr = *lval;  uv_ptr = *uval;  dv_ptr = *uval;
-        lc_ptr = *lcind; uc_ptr = *ucind; dc_ptr = *ucind;
-        lr_ptr = *lrptr; ur_ptr = *urptr;
-    }else if(std::strcmp(key, "L-D-U") == 0) {
-        lv_ptr = *lval;  uv_ptr = *uval;  dv_ptr = *diag;
-        lc_ptr = *lcind; uc_ptr = *ucind; dc_ptr = nullptr;
-        lr_ptr = *lrptr; ur_ptr = *urptr;
-    }else if(std::strcmp(key, "LU-D") == 0) {
-        lv_ptr = *lval;  uv_ptr = *lval;  dv_ptr = *diag;
-        lc_ptr = *lcind; uc_ptr = *lcind; dc_ptr = nullptr;
-        lr_ptr = *lrptr; ur_ptr = *lrptr;
-    }else { return; }
-    lr_ptr[0] = 0;
-    ur_ptr[0] = 0;
+    T *v_ptr[3] = {*lval, (uNNZ != 0) ? *uval : nullptr, (dNNZ == N) ? *diag : nullptr};
+    int *c_ptr[3] = {*lcind, (uNNZ != 0) ? *ucind : nullptr, nullptr};
+    T *lv_ptr = v_ptr[dst[0]], *uv_ptr = v_ptr[dst[1]], *dv_ptr = v_ptr[dst[2]];
+    int *lc_ptr = c_ptr[dst[0]], *uc_ptr = c_ptr[dst[1]], *dc_ptr = c_ptr[dst[2]];
+    int *l_rptr = *lrptr;
+    #pragma omp parallel for
     for(int i=0; i<N; i++) {
+        int pos[3] = {l_rptr[i], u_rptr[i], i};
+        int *l_ptr = &pos[dst[0]], *u_ptr = &pos[dst[1]], *d_ptr = &pos[dst[2]];
         for(int j=rptr[i]; j<rptr[i+1]; j++) {
             if(cind[j] < i) {
                 lv_ptr[*l_ptr] = val[j]; lc_ptr[*l_ptr] = cind[j];
@@ -327,9 +481,9 @@ void Split(
                 (*d_ptr)++;
             }
         }
-        lr_ptr[i+1] = *l_ptr;
-        ur_ptr[i+1] = *u_ptr;
     }
+    if(uNNZ == 0) { free(u_rptr); }
+    free(work);
 }
 
 template <typename T>
@@ -353,18 +507,29 @@ void Expand(
     *val  = utils::SafeMalloc<T>(nnz);
     *cind = utils::SafeMalloc<int>(nnz);
     *rptr = utils::SafeMalloc<int>(N+1);
-    int cnt = 0; (*rptr)[0] = cnt;
-    for(int i=0; i<N; i++) {
-        for(int j=lrptr[i]; j<lrptr[i+1]; j++) {
-            (*val)[cnt] = lval[j]; (*cind)[cnt] = lcind[j];
-            cnt++;
+    (*rptr)[0] = 0;
+    int *work = utils::SafeMalloc<int>(helper::MaxThreads()+1);
+    #pragma omp parallel
+    {
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            (*rptr)[i+1] = (lrptr[i+1]-lrptr[i]) + (urptr[i+1]-urptr[i]-1);
         }
-        for(int j=urptr[i]+1; j<urptr[i+1]; j++) {
-            (*val)[cnt] = uval[j]; (*cind)[cnt] = ucind[j];
-            cnt++;
+        helper::PrefixSum(*rptr, N, work);
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int cnt = (*rptr)[i];
+            for(int j=lrptr[i]; j<lrptr[i+1]; j++) {
+                (*val)[cnt] = lval[j]; (*cind)[cnt] = lcind[j];
+                cnt++;
+            }
+            for(int j=urptr[i]+1; j<urptr[i+1]; j++) {
+                (*val)[cnt] = uval[j]; (*cind)[cnt] = ucind[j];
+                cnt++;
+            }
         }
-        (*rptr)[i+1] = cnt;
     }
+    free(work);
     free(tval2);
     free(tcind2);
     free(trptr2);
@@ -380,6 +545,7 @@ void Duplicate(
     *cind = utils::SafeMalloc<int>(trptr[N]);
     *rptr = utils::SafeMalloc<int>(N+1);
     (*rptr)[0] = trptr[0];
+    #pragma omp parallel for
     for(int i=0; i<N; i++) {
         (*rptr)[i+1] = trptr[i+1];
         for(int j=trptr[i]; j<trptr[i+1]; j++) {
@@ -415,238 +581,676 @@ void Scaling(T *val, int *cind, int *rptr, T *ld, T *rd, int N)
     }
 }
 
-template <typename T>
-void Ilu0(T *val, int *cind, int *rptr, int N)
-{
-    for(int i=1; i<N; i++) {
-        for(int k=rptr[i]; k<rptr[i+1]; k++) {
-            if(cind[k] >= i) break;
-            for(int l=rptr[cind[k]]; l<rptr[cind[k]+1]; l++) {
-                if(cind[l] == cind[k]) {
-                    if(val[l] == 0) {
-                        printf("Error: Ilu0, 0 pivot\n");
-                        exit(1);
-                    }
-                    val[k] = val[k] / val[l];
-                    break;
+inline void IlupSymbolic(
+    int *cind, int *rptr,
+    int **fcind, int **frptr,
+    int N, int p)
+{
+    // The pattern of ILU(p). The row being built is kept as a linked list
+    // sorted by column index (next), so that fill-ins are inserted in place,
+    // and the levels are held in a dense array (lev, -1 if absent).
+    int *lev  = utils::SafeMalloc<int>(N);
+    int *next = utils::SafeMalloc<int>(N+1);
+    for(int i=0; i<N; i++) { lev[i] = -1; }
+    int mlen = rptr[N];
+    *fcind = utils::SafeMalloc<int>(mlen);
+    *frptr = utils::SafeMalloc<int>(N+1);
+    int *flev = utils::SafeMalloc<int>(mlen);
+    int *dptr = utils::SafeMalloc<int>(N);
+    int len = 0;
+    (*frptr)[0] = 0;
+    for(int i=0; i<N; i++) {
+        // head is next[N] and N terminates the list.
+        int prev = N;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            next[prev] = cind[j];
+            lev[cind[j]] = 0;
+            prev = cind[j];
+        }
+        next[prev] = N;
+        int cnt = rptr[i+1] - rptr[i];
+        for(int k=next[N]; k<i; k=next[k]) {
+            if(lev[k] > p) continue;
+            int pos = k;
+            for(int j=dptr[k]+1; j<(*frptr)[k+1]; j++) {
+                int c = (*fcind)[j];
+                int l = lev[k] + flev[j] + 1;
+                if(l > p) continue;
+                while(next[pos] < c) pos = next[pos];
+                if(next[pos] == c) {
+                    if(lev[c] > l) lev[c] = l;
+                }else {
+                    next[c] = next[pos];
+                    next[pos] = c;
+                    lev[c] = l;
+                    cnt++;
                 }
+                pos = c;
             }
-            int pos = rptr[cind[k]];
-            for(int j=k+1; j<rptr[i+1]; j++) {
-                for(int l=pos; l<rptr[cind[k]+1]; l++) {
-                    if(cind[l] < cind[j]) continue;
-                    pos = l;
-                    if(cind[l] == cind[j]) {
-                        val[j] -= val[k] * val[l];
-                        pos++;
-                    }
-                    break;
-                }
+        }
+        if(len + cnt > mlen) {
+            while(len + cnt > mlen) mlen *= 2;
+            *fcind = utils::SafeRealloc<int>(*fcind, mlen);
+            flev = utils::SafeRealloc<int>(flev, mlen);
+        }
+        dptr[i] = -1;
+        for(int k=next[N]; k<N; k=next[k]) {
+            if(lev[k] <= p) {
+                if(k == i) dptr[i] = len;
+                (*fcind)[len] = k;
+                flev[len] = lev[k];
+                len++;
             }
+            lev[k] = -1;
         }
+        if(dptr[i] == -1) {
+            printf("Error: IlupSymbolic, no diagonal\n");
+            exit(1);
+        }
+        (*frptr)[i+1] = len;
     }
+    *fcind = utils::SafeRealloc<int>(*fcind, len);
+    free(lev);
+    free(next);
+    free(flev);
+    free(dptr);
+}
+
+inline long IlupNnz(int *cind, int *rptr, int N, int p)
+{
+    // The number of nonzeros of the ILU(p) factors, to check the fill of an
+    // ordering before the numerical factorization is allocated.
+    int *fcind, *frptr;
+    IlupSymbolic(cind, rptr, &fcind, &frptr, N, p);
+    long nnz = frptr[N];
+    free(fcind);
+    free(frptr);
+    return nnz;
 }
 
 template <typename T>
-void Ilup(T **val, int **cind, int **rptr, int N, int p)
+int IluNumeric(
+    T *val, int *cind, int *rptr,
+    T *fval, int *fcind, int *frptr,
+    int N, T shift = 0)
 {
-    int i, j;
-    //int NNZ = (*rptr)[N];
-    sparse::SpVec<T, int> temp;
-    sparse::SpVec<T, int> temp2;
-    int *zeros = utils::SafeCalloc<int>(N);
+    // The values of the factors on a pattern given by IlupSymbolic (or any
+    // pattern that contains that of A and the diagonal). fval is overwritten,
+    // so this can be called again whenever the values of A change.
+    // The diagonal of each row is moved away from 0 by shift times the largest
+    // magnitude in the row of A (Manteuffel's shift for diagonally dominant
+    // rows). The number of pivots that are not finite or whose magnitude is
+    // below sqrt(epsilon) times that of the row is returned; the factors are
+    // not usable unless it is 0.
+    T tiny = std::sqrt(std::numeric_limits<T>::epsilon());
+    int bad = 0;
+    int *pos  = utils::SafeMalloc<int>(N);
+    int *dptr = utils::SafeMalloc<int>(N);
+    for(int i=0; i<N; i++) { pos[i] = -1; }
+    for(int i=0; i<N; i++) {
+        for(int j=frptr[i]; j<frptr[i+1]; j++) {
+            pos[fcind[j]] = j;
+            fval[j] = 0;
+            if(fcind[j] == i) dptr[i] = j;
+        }
+        T rmax = 0;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            if(pos[cind[j]] != -1) fval[pos[cind[j]]] = val[j];
+            if(rmax < std::abs(val[j])) rmax = std::abs(val[j]);
+        }
+        if(shift != 0) fval[dptr[i]] += (fval[dptr[i]] < 0) ? -shift*rmax : shift*rmax;
+        for(int j=frptr[i]; j<frptr[i+1] && fcind[j]<i; j++) {
+            int k = fcind[j];
+            fval[j] /= fval[dptr[k]];
+            T pivot = fval[j];
+            for(int l=dptr[k]+1; l<frptr[k+1]; l++) {
+                if(pos[fcind[l]] != -1) fval[pos[fcind[l]]] -= pivot * fval[l];
+            }
+        }
+        if(!(std::abs(fval[dptr[i]]) > tiny*rmax)) bad++;
+        for(int j=frptr[i]; j<frptr[i+1]; j++) { pos[fcind[j]] = -1; }
+    }
+    free(pos);
+    free(dptr);
+    return bad;
+}
 
-    T pivot = 0;
-    int pivot_lev = 0;
+template <typename T>
+T Ilu0(T *val, int *cind, int *rptr, int N)
+{
+    // ILU(0) in place. On a breakdown the factorization is restarted from A
+    // with a larger diagonal shift (see IluNumeric), starting from 1e-3 and
+    // doubled each time. The shift used is returned (0 if none was needed).
+    for(int i=0; i<N; i++) {
+        int j;
+        for(j=rptr[i]; j<rptr[i+1] && cind[j]!=i; j++) {}
+        if(j == rptr[i+1]) {
+            printf("Error: Ilu0, no diagonal\n");
+            exit(1);
+        }
+    }
+    T *aval = utils::SafeMalloc<T>(rptr[N]);
+    for(int i=0; i<rptr[N]; i++) { aval[i] = val[i]; }
+    T shift = 0;
+    for(int it=0; IluNumeric<T>(aval, cind, rptr, val, cind, rptr, N, shift) > 0; it++) {
+        if(it == 30) {
+            printf("Error: Ilu0, breakdown with shift %e\n", (double)shift);
+            exit(1);
+        }
+        shift = (shift == 0) ? (T)1e-3 : 2*shift;
+    }
+    free(aval);
+    return shift;
+}
 
-    int first_len = (*rptr)[1] - (*rptr)[0];
-    T   *new_val  = utils::SafeMalloc<T>(first_len);
-    int *new_cind = utils::SafeMalloc<int>(first_len);
-    int *new_lev  = utils::SafeCalloc<int>(first_len);
+template <typename T>
+T Ilup(T **val, int **cind, int **rptr, int N, int p)
+{
+    // The input arrays are replaced by the factors, but not freed.
+    // Breakdowns are handled as in Ilu0 and the shift used is returned.
+    int *fcind, *frptr;
+    IlupSymbolic(*cind, *rptr, &fcind, &frptr, N, p);
+    T *fval = utils::SafeMalloc<T>(frptr[N]);
+    T shift = 0;
+    for(int it=0; IluNumeric<T>(*val, *cind, *rptr, fval, fcind, frptr, N, shift) > 0; it++) {
+        if(it == 30) {
+            printf("Error: Ilup, breakdown with shift %e\n", (double)shift);
+            exit(1);
+        }
+        shift = (shift == 0) ? (T)1e-3 : 2*shift;
+    }
+    *val  = fval;
+    *cind = fcind;
+    *rptr = frptr;
+    return shift;
+}
+
+template <typename T>
+T Ilut(T **val, int **cind, int **rptr, int N, T tau, int p)
+{
+    // ILUT(tau, p): in each row, the entries smaller than tau times the 2-norm
+    // of the row are dropped and at most p entries are kept in each of the L
+    // and U parts. The result has the same layout as that of Ilup and, as in
+    // Ilup, the input arrays are replaced by the factors, but not freed.
+    // The lower entries of a row are eliminated in increasing order of the
+    // column index, taken from a min-heap.
+    // Breakdowns are handled as in Ilu0 and the shift used is returned.
+    sparse::SpVec<T, int> lower;
+    sparse::SpVec<T, int> upper;
+    T tiny = std::sqrt(std::numeric_limits<T>::epsilon());
+    T *w = utils::SafeCalloc<T>(N);
+    bool *nz = utils::SafeCalloc<bool>(N);
+    T *key = utils::SafeMalloc<T>(N);
+    int *sel = utils::SafeMalloc<int>(N);
+    int *heap = utils::SafeMalloc<int>(N);
+    int *dptr = utils::SafeMalloc<int>(N);
+
+    int mlen = (*rptr)[N];
+    T   *new_val  = utils::SafeMalloc<T>(mlen);
+    int *new_cind = utils::SafeMalloc<int>(mlen);
     int *new_rptr = utils::SafeMalloc<int>(N+1);
-    int new_len = first_len;
-    //一行目
-    memcpy(new_val, *val, sizeof(T)*first_len);
-    memcpy(new_cind, *cind, sizeof(int)*first_len);
+    int new_len = 0;
     new_rptr[0] = 0;
-    new_rptr[1] = first_len;
-
-    for(i=1; i<N; i++) {
-        int now_len = (*rptr)[i+1] - (*rptr)[i];
-        temp.Clear();
-        temp.Append(&(*val)[(*rptr)[i]], zeros, &(*cind)[(*rptr)[i]], now_len);
-        int count = 0;
-        while(count < temp.GetLen() && temp.GetIdx(count) < i) {
-            int k_ptr = count;
-            if(temp.GetLev(k_ptr) > p) { count++; continue; }
-            int k = temp.GetIdx(k_ptr);
-            temp2.Clear();
-            for(j=0; j<count; j++) {
-                temp2.Append(temp.GetVal(j), temp.GetLev(j), temp.GetIdx(j));
-            }
-            for(j=new_rptr[k]; j<new_rptr[k+1]; j++) {
-                if(new_cind[j] == k) {
-                    pivot = temp.GetVal(k_ptr) / new_val[j];
-                    pivot_lev = temp.GetLev(k_ptr);
-                    break;
-                }
+
+    T shift = 0;
+    for(int it=0; ; it++) {
+        bool bad = false;
+        new_len = 0;
+        for(int i=0; i<N && !bad; i++) {
+            lower.Clear();
+            upper.Clear();
+            int hlen = 0;
+            T norm = 0;
+            T rmax = 0;
+            nz[i] = true;
+            for(int j=(*rptr)[i]; j<(*rptr)[i+1]; j++) {
+                int c = (*cind)[j];
+                w[c] = (*val)[j];
+                norm += (*val)[j] * (*val)[j];
+                if(rmax < std::abs((*val)[j])) rmax = std::abs((*val)[j]);
+                if(c < i) { lower.Append(0, 0, c); helper::HeapPush<int>(heap, &hlen, c); }
+                else if(c > i) upper.Append(0, 0, c);
+                nz[c] = true;
             }
-            j++;
-            k_ptr++;
-            temp2.Append(pivot, 0, k);
-            while(k_ptr<temp.GetLen() || j<new_rptr[k+1]) {
-                int t_col1 = N+1;
-                int t_col2 = N+1;
-                if(k_ptr < temp.GetLen()) t_col1 = temp.GetIdx(k_ptr);
-                if(j < new_rptr[k+1]) t_col2 = new_cind[j];
-                if(t_col1<t_col2) {
-                    T t_val = temp.GetVal(k_ptr);
-                    int t_lev    = temp.GetLev(k_ptr);
-                    int t_col    = temp.GetIdx(k_ptr);
-                    temp2.Append(t_val, t_lev, t_col);
-                    k_ptr++;
-                }else if(t_col1==t_col2) {
-                    T t_val = temp.GetVal(k_ptr) - pivot*new_val[j];
-                    int t_lev    = temp.GetLev(k_ptr);
-                    int t_col    = temp.GetIdx(k_ptr);
-                    if(t_lev > pivot_lev+new_lev[j]+1) {
-                        t_lev = pivot_lev+new_lev[j]+1;
+            if(shift != 0) w[i] += (w[i] < 0) ? -shift*rmax : shift*rmax;
+            T tau_i = tau * std::sqrt(norm);
+            // Eliminate the lower part in increasing order of the column index.
+            while(hlen > 0) {
+                int k = helper::HeapPop<int>(heap, &hlen);
+                w[k] /= new_val[dptr[k]];
+                if(std::abs(w[k]) < tau_i) { w[k] = 0; continue; }
+                for(int j=dptr[k]+1; j<new_rptr[k+1]; j++) {
+                    int c = new_cind[j];
+                    if(!nz[c]) {
+                        nz[c] = true;
+                        w[c] = 0;
+                        if(c < i) { lower.Append(0, 0, c); helper::HeapPush<int>(heap, &hlen, c); }
+                        else upper.Append(0, 0, c);
                     }
-                    temp2.Append(t_val, t_lev, t_col);
-                    k_ptr++;
-                    j++;
-                }else { // (k>j) fill-in
-                    T t_val = -pivot*new_val[j];
-                    int t_lev    = pivot_lev+new_lev[j]+1;
-                    int t_col    = new_cind[j];
-                    //printf("lev %d\n", t_lev);
-                    temp2.Append(t_val, t_lev, t_col);
-                    j++;
+                    w[c] -= w[k] * new_val[j];
                 }
             }
-            count++;
-            temp.Clear();
-            for(j=0; j<temp2.GetLen(); j++) {
-                temp.Append(temp2.GetVal(j), temp2.GetLev(j), temp2.GetIdx(j));
+            if(!(std::abs(w[i]) > tiny*rmax)) {
+                bad = true;
+            }else {
+                if(new_len + lower.GetLen() + upper.GetLen() + 1 > mlen) {
+                    while(new_len + lower.GetLen() + upper.GetLen() + 1 > mlen) mlen *= 2;
+                    new_val  = utils::SafeRealloc<T>(new_val, mlen);
+                    new_cind = utils::SafeRealloc<int>(new_cind, mlen);
+                }
+                // Keep the p largest entries of each part.
+                for(int part=0; part<2; part++) {
+                    sparse::SpVec<T, int> &list = (part == 0) ? lower : upper;
+                    int cnt = 0;
+                    for(int t=0; t<list.GetLen(); t++) {
+                        int c = list.GetIdx(t);
+                        if(w[c] != 0 && std::abs(w[c]) >= tau_i) {
+                            key[cnt] = std::abs(w[c]);
+                            sel[cnt] = c;
+                            cnt++;
+                        }
+                    }
+                    if(cnt > p) {
+                        helper::QuickSortDesc<T, int>(key, sel, 0, cnt-1);
+                        cnt = p;
+                    }
+                    if(cnt > 1) helper::QuickSort<int>(sel, 0, cnt-1);
+                    if(part == 1) {
+                        dptr[i] = new_len;
+                        new_val[new_len] = w[i];
+                        new_cind[new_len] = i;
+                        new_len++;
+                    }
+                    for(int t=0; t<cnt; t++) {
+                        new_val[new_len] = w[sel[t]];
+                        new_cind[new_len] = sel[t];
+                        new_len++;
+                    }
+                }
+                new_rptr[i+1] = new_len;
             }
+            for(int t=0; t<lower.GetLen(); t++) { w[lower.GetIdx(t)] = 0; nz[lower.GetIdx(t)] = false; }
+            for(int t=0; t<upper.GetLen(); t++) { w[upper.GetIdx(t)] = 0; nz[upper.GetIdx(t)] = false; }
+            w[i] = 0;
+            nz[i] = false;
         }
-        new_val  = utils::SafeRealloc<T>(new_val, new_len+temp.GetLen());
-        new_cind = utils::SafeRealloc<int>(new_cind, new_len+temp.GetLen());
-        new_lev  = utils::SafeRealloc<int>(new_lev, new_len+temp.GetLen());
-        for(j=0; j<temp.GetLen(); j++) {
-            if(temp.GetLev(j) <= p) {
-                new_val[new_len]  = temp.GetVal(j);
-                new_cind[new_len] = temp.GetIdx(j);
-                new_lev[new_len]  = temp.GetLev(j);
-                new_len++;
-            }
+        if(!bad) break;
+        if(it == 30) {
+            printf("Error: Ilut, breakdown with shift %e\n", (double)shift);
+            exit(1);
         }
-        new_rptr[i+1] = new_len;
+        shift = (shift == 0) ? (T)1e-3 : 2*shift;
     }
     (*val)  = utils::SafeRealloc<T>(new_val, new_len);
     (*cind) = utils::SafeRealloc<int>(new_cind, new_len);
-    (*rptr) = utils::SafeRealloc<int>(new_rptr, N+1);
+    (*rptr) = new_rptr;
+    free(w);
+    free(nz);
+    free(key);
+    free(sel);
+    free(heap);
+    free(dptr);
+    return shift;
 }
 
 template <typename T>
-void AllocLevelZero(T **val, int **cind, int **rptr, int N, int p)
+T Bilup(
+    T *val, int *cind, int *rptr,
+    T **blval, int **blcind, int **blrptr,
+    T **buval, int **bucind, int **burptr,
+    int N, int bs, int p)
 {
-    int i, j;
-    //int NNZ = (*rptr)[N];
-    sparse::SpVec<T, int> temp;
-    sparse::SpVec<T, int> temp2;
-    int *zeros = utils::SafeCalloc<int>(N);
-
-    T pivot = 0;
-    int pivot_lev = 0;
-
-    int first_len = (*rptr)[1] - (*rptr)[0];
-    T   *new_val  = utils::SafeMalloc<T>(first_len);
-    int *new_cind = utils::SafeMalloc<int>(first_len);
-    int *new_lev  = utils::SafeCalloc<int>(first_len);
-    int *new_rptr = utils::SafeMalloc<int>(N+1);
-    int new_len = first_len;
-    //一行目
-    memcpy(new_val, *val, sizeof(T)*first_len);
-    memcpy(new_cind, *cind, sizeof(int)*first_len);
-    new_rptr[0] = 0;
-    new_rptr[1] = first_len;
-
-    for(i=1; i<N; i++) {
-        int now_len = (*rptr)[i+1] - (*rptr)[i];
-        temp.Clear();
-        temp.Append(&(*val)[(*rptr)[i]], zeros, &(*cind)[(*rptr)[i]], now_len);
-        int count = 0;
-        while(count < temp.GetLen() && temp.GetIdx(count) < i) {
-            int k_ptr = count;
-            if(temp.GetLev(k_ptr) > p) { count++; continue; }
-            int k = temp.GetIdx(k_ptr);
-            temp2.Clear();
-            for(j=0; j<count; j++) {
-                temp2.Append(temp.GetVal(j), temp.GetLev(j), temp.GetIdx(j));
-            }
-            for(j=new_rptr[k]; j<new_rptr[k+1]; j++) {
-                if(new_cind[j] == k) {
-                    pivot = temp.GetVal(k_ptr);// / new_val[j];
-                    pivot_lev = temp.GetLev(k_ptr);
-                    break;
+    // Block ILU(p): the elimination is performed on the graph of the bs x bs
+    // blocks with dense block operations. The blocks are stored column-major
+    // as in Csr2Bcsr, L is unit block lower triangular (the identity blocks
+    // are not stored) and the diagonal blocks of U, which come first in each
+    // block row, are replaced by their inverses.
+    // When N is not a multiple of bs, the last diagonal block is completed
+    // by the identity.
+    // Breakdowns are handled as in Ilu0: the diagonal of each row is moved
+    // away from 0 by shift times the largest magnitude in the row of A, and
+    // the factorization is restarted from A with a larger shift while a pivot
+    // of a diagonal block is not finite or below sqrt(epsilon) times the
+    // largest magnitude in its block row. The shift used is returned.
+    int nb = (N+bs-1) / bs;
+    int b_size = bs * bs;
+    // Block pattern of A with the diagonal
+    int *acind = utils::SafeMalloc<int>(rptr[N]+nb);
+    int *arptr = utils::SafeMalloc<int>(nb+1);
+    int *pos = utils::SafeMalloc<int>(nb);
+    for(int i=0; i<nb; i++) { pos[i] = -1; }
+    int len = 0;
+    arptr[0] = 0;
+    for(int ib=0; ib<nb; ib++) {
+        pos[ib] = ib;
+        acind[len++] = ib;
+        for(int i=ib*bs; i<(ib+1)*bs && i<N; i++) {
+            for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                int c = cind[j] / bs;
+                if(pos[c] == ib) continue;
+                pos[c] = ib;
+                acind[len++] = c;
+            }
+        }
+        helper::QuickSort<int>(acind, arptr[ib], len-1);
+        arptr[ib+1] = len;
+    }
+    int *fcind, *frptr;
+    IlupSymbolic(acind, arptr, &fcind, &frptr, nb, p);
+    free(acind);
+    free(arptr);
+    // Numeric phase
+    T tiny = std::sqrt(std::numeric_limits<T>::epsilon());
+    T *fval = utils::SafeMalloc<T>(frptr[nb]*b_size);
+    int *dptr = utils::SafeMalloc<int>(nb);
+    T *work = utils::SafeMalloc<T>(b_size);
+    int *piv = utils::SafeMalloc<int>(bs);
+    for(int i=0; i<nb; i++) { pos[i] = -1; }
+    T shift = 0;
+    for(int it=0; ; it++) {
+        int bad = 0;
+        for(int l=0; l<frptr[nb]*b_size; l++) { fval[l] = 0; }
+        for(int ib=0; ib<nb; ib++) {
+            for(int j=frptr[ib]; j<frptr[ib+1]; j++) {
+                pos[fcind[j]] = j;
+                if(fcind[j] == ib) dptr[ib] = j;
+            }
+            T brmax = 0;
+            for(int r=0; r<bs; r++) {
+                int i = ib*bs+r;
+                if(i >= N) {
+                    fval[dptr[ib]*b_size + r*bs + r] = 1;
+                    continue;
+                }
+                T rmax = 0;
+                for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                    fval[pos[cind[j]/bs]*b_size + (cind[j]%bs)*bs + r] = val[j];
+                    if(rmax < std::abs(val[j])) rmax = std::abs(val[j]);
                 }
+                T *d = &fval[dptr[ib]*b_size + r*bs + r];
+                if(shift != 0) *d += (*d < 0) ? -shift*rmax : shift*rmax;
+                if(brmax < rmax) brmax = rmax;
             }
-            j++;
-            k_ptr++;
-            temp2.Append(pivot, 0, k);
-            while(k_ptr<temp.GetLen() || j<new_rptr[k+1]) {
-                int t_col1 = N+1;
-                int t_col2 = N+1;
-                if(k_ptr < temp.GetLen()) t_col1 = temp.GetIdx(k_ptr);
-                if(j < new_rptr[k+1]) t_col2 = new_cind[j];
-                if(t_col1<t_col2) {
-                    T t_val = temp.GetVal(k_ptr);
-                    int t_lev    = temp.GetLev(k_ptr);
-                    int t_col    = temp.GetIdx(k_ptr);
-                    temp2.Append(t_val, t_lev, t_col);
-                    k_ptr++;
-                }else if(t_col1==t_col2) {
-                    T t_val = temp.GetVal(k_ptr);
-                    int t_lev    = temp.GetLev(k_ptr);
-                    int t_col    = temp.GetIdx(k_ptr);
-                    if(t_lev > pivot_lev+new_lev[j]+1) {
-                        t_lev = pivot_lev+new_lev[j]+1;
+            for(int j=frptr[ib]; fcind[j]<ib; j++) {
+                int k = fcind[j];
+                // L_ik = A_ik * inv(U_kk)
+                T *lik = &fval[j*b_size];
+                T *dk = &fval[dptr[k]*b_size];
+                for(int c=0; c<bs; c++) {
+                    for(int r=0; r<bs; r++) { work[c*bs+r] = 0; }
+                    for(int l=0; l<bs; l++) {
+                        T temp = dk[c*bs+l];
+                        for(int r=0; r<bs; r++) { work[c*bs+r] += lik[l*bs+r] * temp; }
                     }
-                    temp2.Append(t_val, t_lev, t_col);
-                    k_ptr++;
-                    j++;
-                }else { // (k>j) fill-in
-                    T t_val = 0;
-                    int t_lev    = pivot_lev+new_lev[j]+1;
-                    int t_col    = new_cind[j];
-                    //printf("lev %d\n", t_lev);
-                    temp2.Append(t_val, t_lev, t_col);
-                    j++;
                 }
+                for(int l=0; l<b_size; l++) { lik[l] = work[l]; }
+                // A_ij -= L_ik * U_kj
+                for(int l=dptr[k]+1; l<frptr[k+1]; l++) {
+                    if(pos[fcind[l]] == -1) continue;
+                    T *aij = &fval[pos[fcind[l]]*b_size];
+                    T *ukj = &fval[l*b_size];
+                    for(int c=0; c<bs; c++) {
+                        for(int m=0; m<bs; m++) {
+                            T temp = ukj[c*bs+m];
+                            for(int r=0; r<bs; r++) { aij[c*bs+r] -= lik[m*bs+r] * temp; }
+                        }
+                    }
+                }
+            }
+            // Invert the diagonal block
+            T *di = &fval[dptr[ib]*b_size];
+            for(int l=0; l<b_size; l++) { work[l] = di[l]; }
+            blas2::Getrf<T>(work, piv, bs);
+            for(int c=0; c<bs; c++) {
+                if(!(std::abs(work[c*bs+c]) > tiny*brmax)) bad++;
             }
-            count++;
-            temp.Clear();
-            for(j=0; j<temp2.GetLen(); j++) {
-                temp.Append(temp2.GetVal(j), temp2.GetLev(j), temp2.GetIdx(j));
+            for(int c=0; c<bs; c++) {
+                for(int r=0; r<bs; r++) { di[c*bs+r] = (r == c) ? 1 : 0; }
+                blas2::Getrs<T>(work, piv, &di[c*bs], &di[c*bs], bs);
             }
+            for(int j=frptr[ib]; j<frptr[ib+1]; j++) { pos[fcind[j]] = -1; }
         }
-        new_val  = utils::SafeRealloc<T>(new_val, new_len+temp.GetLen());
-        new_cind = utils::SafeRealloc<int>(new_cind, new_len+temp.GetLen());
-        new_lev  = utils::SafeRealloc<int>(new_lev, new_len+temp.GetLen());
-        for(j=0; j<temp.GetLen(); j++) {
-            if(temp.GetLev(j) <= p) {
-                new_val[new_len]  = temp.GetVal(j);
-                new_cind[new_len] = temp.GetIdx(j);
-                new_lev[new_len]  = temp.GetLev(j);
-                new_len++;
+        if(bad == 0) break;
+        if(it == 30) {
+            printf("Error: Bilup, breakdown with shift %e\n", (double)shift);
+            exit(1);
+        }
+        shift = (shift == 0) ? (T)1e-3 : 2*shift;
+    }
+    free(work);
+    free(piv);
+    free(pos);
+    // Split into L and U
+    int lnnz = 0;
+    for(int ib=0; ib<nb; ib++) { lnnz += dptr[ib] - frptr[ib]; }
+    int unnz = frptr[nb] - lnnz;
+    *blval  = utils::SafeMalloc<T>(lnnz*b_size);
+    *blcind = utils::SafeMalloc<int>(lnnz);
+    *blrptr = utils::SafeMalloc<int>(nb+1);
+    *buval  = utils::SafeMalloc<T>(unnz*b_size);
+    *bucind = utils::SafeMalloc<int>(unnz);
+    *burptr = utils::SafeMalloc<int>(nb+1);
+    int lcnt = 0, ucnt = 0;
+    (*blrptr)[0] = 0;
+    (*burptr)[0] = 0;
+    for(int ib=0; ib<nb; ib++) {
+        for(int j=frptr[ib]; j<frptr[ib+1]; j++) {
+            if(j < dptr[ib]) {
+                for(int l=0; l<b_size; l++) { (*blval)[lcnt*b_size+l] = fval[j*b_size+l]; }
+                (*blcind)[lcnt++] = fcind[j];
+            }else {
+                for(int l=0; l<b_size; l++) { (*buval)[ucnt*b_size+l] = fval[j*b_size+l]; }
+                (*bucind)[ucnt++] = fcind[j];
             }
         }
-        new_rptr[i+1] = new_len;
+        (*blrptr)[ib+1] = lcnt;
+        (*burptr)[ib+1] = ucnt;
     }
-    (*val)  = utils::SafeRealloc<T>(new_val, new_len);
-    (*cind) = utils::SafeRealloc<int>(new_cind, new_len);
-    (*rptr) = utils::SafeRealloc<int>(new_rptr, N+1);
+    free(fval);
+    free(fcind);
+    free(frptr);
+    free(dptr);
+    return shift;
+}
+
+template <typename T>
+void Ssor(
+    T *val, int *cind, int *rptr,
+    T **lval, int **lcind, int **lrptr,
+    T **uval, int **ucind, int **urptr,
+    int N, T omega)
+{
+    // M = (D+omega*L) D^-1 (D+omega*U) / (omega*(2-omega)) is stored as a unit
+    // lower and an upper (inverted diagonal) factor, the "L-DU" form of Ilu0.
+    T *diag;
+    GetDiag<T>(val, cind, rptr, &diag, N);
+    for(int i=0; i<N; i++) {
+        if(diag[i] == 0) {
+            printf("Error: Ssor, 0 diagonal\n");
+            exit(1);
+        }
+    }
+    Split<T>(val, cind, rptr, lval, lcind, lrptr, uval, ucind, urptr, nullptr, N, "L-DU", true);
+    #pragma omp parallel for
+    for(int i=0; i<N; i++) {
+        for(int j=(*lrptr)[i]; j<(*lrptr)[i+1]; j++) {
+            (*lval)[j] *= omega / diag[(*lcind)[j]];
+        }
+        (*uval)[(*urptr)[i]] *= omega * (2 - omega);
+        for(int j=(*urptr)[i]+1; j<(*urptr)[i+1]; j++) {
+            (*uval)[j] /= 2 - omega;
+        }
+    }
+    free(diag);
+}
+
+template <typename T>
+void GaussSeidel(
+    T *val, int *cind, int *rptr,
+    T **lval, int **lcind, int **lrptr,
+    T **uval, int **ucind, int **urptr,
+    int N)
+{
+    // M = D+L = (I+L D^-1) D, so U keeps only the inverted diagonal.
+    Ssor<T>(val, cind, rptr, lval, lcind, lrptr, uval, ucind, urptr, N, 1);
+    for(int i=0; i<N; i++) {
+        (*uval)[i] = (*uval)[(*urptr)[i]];
+        (*ucind)[i] = i;
+        (*urptr)[i] = i;
+    }
+    (*urptr)[N] = N;
+    (*uval)  = utils::SafeRealloc<T>(*uval, N);
+    (*ucind) = utils::SafeRealloc<int>(*ucind, N);
+}
+
+template <typename T>
+void Fsai(
+    T *val, int *cind, int *rptr,
+    T **gval, int **gcind, int **grptr,
+    int N, int k)
+{
+    // G is lower triangular with the pattern of the lower part of A^k and
+    // G^T G approximates A^-1 for an SPD A. Each row solves A(J,J) y = e_i on
+    // its pattern J and is scaled by 1/sqrt(y_i).
+    int *pcind, *prptr;
+    PowerPattern(cind, rptr, &pcind, &prptr, N, k);
+    *grptr = utils::SafeMalloc<int>(N+1);
+    (*grptr)[0] = 0;
+    for(int i=0; i<N; i++) {
+        int cnt = 0;
+        for(int j=prptr[i]; j<prptr[i+1]; j++) { if(pcind[j] <= i) cnt++; }
+        (*grptr)[i+1] = (*grptr)[i] + cnt;
+    }
+    *gval  = utils::SafeMalloc<T>((*grptr)[N]);
+    *gcind = utils::SafeMalloc<int>((*grptr)[N]);
+    int max = 0;
+    for(int i=0; i<N; i++) {
+        if(max < (*grptr)[i+1] - (*grptr)[i]) max = (*grptr)[i+1] - (*grptr)[i];
+    }
+    bool flag = true;
+    #pragma omp parallel reduction(&&:flag)
+    {
+        int *pos = utils::SafeMalloc<int>(N);
+        T *A = utils::SafeMalloc<T>(max*max);
+        T *e = utils::SafeMalloc<T>(max);
+        T *y = utils::SafeMalloc<T>(max);
+        for(int i=0; i<N; i++) { pos[i] = -1; }
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int *J = &(*gcind)[(*grptr)[i]];
+            int n = 0;
+            for(int j=prptr[i]; j<prptr[i+1]; j++) {
+                if(pcind[j] > i) continue;
+                J[n] = pcind[j];
+                pos[J[n]] = n;
+                n++;
+            }
+            for(int t=0; t<n*n; t++) { A[t] = 0; }
+            for(int r=0; r<n; r++) {
+                for(int j=rptr[J[r]]; j<rptr[J[r]+1]; j++) {
+                    if(pos[cind[j]] != -1) A[pos[cind[j]]*n+r] = val[j];
+                }
+                e[r] = 0;
+            }
+            e[n-1] = 1;
+            blas2::Gesv<T>(A, e, y, n);
+            if(!(y[n-1] > 0)) {
+                flag = false;
+            }else {
+                T scale = 1 / std::sqrt(y[n-1]);
+                for(int r=0; r<n; r++) { (*gval)[(*grptr)[i]+r] = y[r] * scale; }
+            }
+            for(int r=0; r<n; r++) { pos[J[r]] = -1; }
+        }
+        free(pos);
+        free(A);
+        free(e);
+        free(y);
+    }
+    if(!flag) {
+        printf("Error: Fsai, not positive definite\n");
+        exit(1);
+    }
+    free(pcind);
+    free(prptr);
+}
+
+template <typename T>
+void Spai(
+    T *val, int *cind, int *rptr,
+    T **mval, int **mcind, int **mrptr,
+    int N, int k)
+{
+    // M has the pattern of A^k and each row minimizes ||m_i A - e_i||_2, so
+    // that M A approximates I. With J the pattern of m_i and I the columns of
+    // the rows J of A, this is a least-squares problem of size |I| * |J|.
+    PowerPattern(cind, rptr, mcind, mrptr, N, k);
+    *mval = utils::SafeMalloc<T>((*mrptr)[N]);
+    int maxJ = 0, maxI = 0;
+    for(int i=0; i<N; i++) {
+        int nI = 1;
+        for(int j=(*mrptr)[i]; j<(*mrptr)[i+1]; j++) {
+            nI += rptr[(*mcind)[j]+1] - rptr[(*mcind)[j]];
+        }
+        if(maxJ < (*mrptr)[i+1] - (*mrptr)[i]) maxJ = (*mrptr)[i+1] - (*mrptr)[i];
+        if(maxI < nI) maxI = nI;
+    }
+    #pragma omp parallel
+    {
+        int *pos = utils::SafeMalloc<int>(N);
+        int *I = utils::SafeMalloc<int>(maxI);
+        T *B = utils::SafeMalloc<T>(maxI*maxJ);
+        T *e = utils::SafeMalloc<T>(maxI);
+        for(int i=0; i<N; i++) { pos[i] = -1; }
+        #pragma omp for
+        for(int i=0; i<N; i++) {
+            int *J = &(*mcind)[(*mrptr)[i]];
+            int n = (*mrptr)[i+1] - (*mrptr)[i];
+            int m = 0;
+            for(int t=0; t<n; t++) {
+                for(int j=rptr[J[t]]; j<rptr[J[t]+1]; j++) {
+                    if(pos[cind[j]] == -1) { pos[cind[j]] = m; I[m] = cind[j]; m++; }
+                }
+            }
+            if(pos[i] == -1) { pos[i] = m; I[m] = i; m++; }
+            for(int t=0; t<m*n; t++) { B[t] = 0; }
+            for(int t=0; t<n; t++) {
+                for(int j=rptr[J[t]]; j<rptr[J[t]+1]; j++) {
+                    B[t*m+pos[cind[j]]] = val[j];
+                }
+            }
+            for(int t=0; t<m; t++) { e[t] = 0; }
+            e[pos[i]] = 1;
+            blas2::Gels<T>(B, e, &(*mval)[(*mrptr)[i]], m, n);
+            for(int t=0; t<m; t++) { pos[I[t]] = -1; }
+        }
+        free(pos);
+        free(I);
+        free(B);
+        free(e);
+    }
+}
+
+template <typename T>
+void AllocLevelZero(T **val, int **cind, int **rptr, int N, int p)
+{
+    // The pattern of ILU(p) with zeros at the fill-ins. The input arrays are
+    // replaced, but not freed.
+    int *fcind, *frptr;
+    IlupSymbolic(*cind, *rptr, &fcind, &frptr, N, p);
+    T *fval = utils::SafeMalloc<T>(frptr[N]);
+    for(int i=0; i<N; i++) {
+        int pos = frptr[i];
+        for(int j=(*rptr)[i]; j<(*rptr)[i+1]; j++) {
+            while(fcind[pos] < (*cind)[j]) { fval[pos] = 0; pos++; }
+            fval[pos] = (*val)[j];
+            pos++;
+        }
+        for(; pos<frptr[i+1]; pos++) { fval[pos] = 0; }
+    }
+    *val  = fval;
+    *cind = fcind;
+    *rptr = frptr;
 }
 
 template <typename T>
@@ -668,12 +1272,13 @@ void AllocBlockZero(T **val, int **cind, int **rptr, int N, int bnl, int bnw)
 template <typename T>
 void RemoveOffDiagonal(T **val, int **cind, int **rptr, int N, int bnum)
 {
-    int bsize = N / bnum;
+    // Block k has the rows floor(k*N/bnum), ..., floor((k+1)*N/bnum)-1.
     int off = 0;
     for(int i=0; i<N; i++) {
         int start = (*rptr)[i]+off;
-        int min = i / bsize * bsize;
-        int max = min + bsize;
+        long k = ((long)(i+1)*bnum-1) / N;
+        int min = (int)(k*N/bnum);
+        int max = (int)((k+1)*N/bnum);
         for(int j=start; j<(*rptr)[i+1]; j++) {
             if((*cind)[j] < min || max <= (*cind)[j]) {
                 off++;
@@ -0,0 +1,243 @@
+/**
+ * @file senk_sai.hpp
+ * @brief The sparse approximate inverse preconditioned solvers are defined.
+ * @author Kengo Suzuki
+ * @date 5/8/2021
+ */
+#ifndef SENK_SAI_HPP
+#define SENK_SAI_HPP
+
+#include <cmath>
+
+#include "senk_sparse.hpp"
+#include "senk_blas1.hpp"
+#include "senk_blas2.hpp"
+#include "senk_helper.hpp"
+
+namespace senk {
+
+namespace solver {
+/**
+ * @brief The FSAI preconditioned GMRES(m) solver.
+ * @details The preconditioner G^T G is applied by two SpMVs in the SELL-c format.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param gval val array of G, given by matrix::Fsai, in the SELL-c format.
+ * @param gcind column index array of G in the SELL-c format.
+ * @param gwid slice pointer array of G in the SELL-c format.
+ * @param gtval val array of G^T in the SELL-c format.
+ * @param gtcind column index array of G^T in the SELL-c format.
+ * @param gtwid slice pointer array of G^T in the SELL-c format.
+ * @param size The size of the slices.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, typename TV = T>
+void FsaiGmresm(
+    T *val, int *cind, int *rptr,
+    T *gval, int *gcind, int *gwid,
+    T *gtval, int *gtcind, int *gtwid, int size,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *u   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SpmvSell<T>(gval, gcind, gwid, size, w, u, N);
+                sparse::orphan::SpmvSell<T>(gtval, gtcind, gtwid, size, u, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
+            }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SpmvSell<T>(gval, gcind, gwid, size, W, u, N);
+            sparse::orphan::SpmvSell<T>(gtval, gtcind, gtwid, size, u, t, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] u;
+    delete[] red;
+}
+/**
+ * @brief The SPAI preconditioned GMRES(m) solver.
+ * @details The approximate inverse is applied by an SpMV in the SELL-c format.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param mval val array of M, given by matrix::Spai, in the SELL-c format.
+ * @param mcind column index array of M in the SELL-c format.
+ * @param mwid slice pointer array of M in the SELL-c format.
+ * @param size The size of the slices.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, typename TV = T>
+void SpaiGmresm(
+    T *val, int *cind, int *rptr,
+    T *mval, int *mcind, int *mwid, int size,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                sparse::orphan::SpmvSell<T>(mval, mcind, mwid, size, w, t, N);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
+            }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            sparse::orphan::SpmvSell<T>(mval, mcind, mwid, size, W, t, N);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] red;
+}
+
+} // namespace solver
+
+} // namespace senk
+
+#endif
@@ -0,0 +1,339 @@
+/**
+ * @file senk_schwarz.hpp
+ * @brief The restricted additive Schwarz preconditioner is defined.
+ * @author Kengo Suzuki
+ * @date 5/8/2021
+ */
+#ifndef SENK_SCHWARZ_HPP
+#define SENK_SCHWARZ_HPP
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "senk_utils.hpp"
+#include "senk_matrix.hpp"
+#include "senk_graph.hpp"
+#include "senk_sparse.hpp"
+#include "senk_blas1.hpp"
+#include "senk_blas2.hpp"
+#include "senk_helper.hpp"
+
+namespace senk {
+/**
+ * @brief The domain decomposition preconditioners are located in namespace schwarz.
+ */
+namespace schwarz {
+/**
+ * @brief The restricted additive Schwarz (RAS) preconditioner with local ILU(p) factors.
+ * @details The graph of the matrix is split into num_part parts by
+ * graph::BfsPartition or graph::MultilevelPartition and each part is extended by overlap layers of
+ * neighbors. Each extended subdomain is factorized by ILU(p). Apply solves
+ * all subdomains independently and keeps only the values of the nodes that
+ * the subdomain owns, so no summation over the overlap is needed.
+ * @tparam T The type of the matrix and vectors.
+ */
+template <typename T>
+class Ras {
+private:
+    //! The number of subdomains.
+    int num_part;
+    //! The number of nodes owned by each subdomain.
+    int *num_own;
+    //! The number of nodes of each extended subdomain.
+    int *num_loc;
+    //! The global indices of the nodes of each subdomain, owned ones first.
+    int **idx;
+    //! val arrays of the local L factors.
+    T **lval;
+    //! cind arrays of the local L factors.
+    int **lcind;
+    //! rptr arrays of the local L factors.
+    int **lrptr;
+    //! val arrays of the local U factors.
+    T **uval;
+    //! cind arrays of the local U factors.
+    int **ucind;
+    //! rptr arrays of the local U factors.
+    int **urptr;
+    //! Local work vectors.
+    T **work;
+public:
+    /**
+     * @brief Constructor.
+     * @details The subdomains are set up in parallel.
+     * @param val val array of the CSR storage format.
+     * @param cind column index array of the CSR storage format.
+     * @param rptr row pointer array of the CSR storage format.
+     * @param N The size of the matrix.
+     * @param a_num_part The number of subdomains.
+     * @param overlap The number of layers of neighbors added to each part.
+     * @param p The fill level of the local ILU factors.
+     * @param isSym Whether the input matrix is symmetric or not.
+     * @param pmethod Specify the partitioning method: "bfs" or "multilevel".
+     */
+    Ras(
+        T *val, int *cind, int *rptr, int N,
+        int a_num_part, int overlap, int p, bool isSym,
+        const char *pmethod = "bfs")
+    {
+        num_part = a_num_part;
+        num_own = utils::SafeCalloc<int>(num_part);
+        num_loc = utils::SafeMalloc<int>(num_part);
+        idx   = utils::SafeMalloc<int*>(num_part);
+        lval  = utils::SafeMalloc<T*>(num_part);
+        lcind = utils::SafeMalloc<int*>(num_part);
+        lrptr = utils::SafeMalloc<int*>(num_part);
+        uval  = utils::SafeMalloc<T*>(num_part);
+        ucind = utils::SafeMalloc<int*>(num_part);
+        urptr = utils::SafeMalloc<int*>(num_part);
+        work  = utils::SafeMalloc<T*>(num_part);
+        int *part;
+        if(std::strcmp(pmethod, "bfs") == 0) {
+            graph::BfsPartition(cind, rptr, &part, N, num_part, isSym);
+        }else if(std::strcmp(pmethod, "multilevel") == 0) {
+            graph::MultilevelPartition(cind, rptr, &part, N, num_part, isSym);
+        }else {
+            printf("Error: Ras\n");
+            printf("The partitioning method is invalid\n");
+            exit(1);
+        }
+        int *am_cind, *am_rptr;
+        graph::GetAdjacency(cind, rptr, &am_cind, &am_rptr, N, isSym);
+        int *ptr = utils::SafeCalloc<int>(num_part+1);
+        for(int i=0; i<N; i++) { num_own[part[i]]++; }
+        for(int k=0; k<num_part; k++) { ptr[k+1] = ptr[k] + num_own[k]; }
+        int *own = utils::SafeMalloc<int>(N);
+        for(int i=0; i<N; i++) { own[ptr[part[i]]] = i; ptr[part[i]]++; }
+        for(int k=0; k<num_part; k++) { ptr[k] -= num_own[k]; }
+        #pragma omp parallel
+        {
+            int *loc = utils::SafeMalloc<int>(N);
+            for(int i=0; i<N; i++) { loc[i] = -1; }
+            #pragma omp for schedule(dynamic)
+            for(int k=0; k<num_part; k++) {
+                // Owned nodes and overlap layers
+                int n = num_own[k];
+                int cap = 2 * n;
+                idx[k] = utils::SafeMalloc<int>(cap);
+                for(int i=0; i<n; i++) {
+                    idx[k][i] = own[ptr[k]+i];
+                    loc[idx[k][i]] = i;
+                }
+                int start = 0;
+                for(int lev=0; lev<overlap; lev++) {
+                    int end = n;
+                    for(int t=start; t<end; t++) {
+                        int g = idx[k][t];
+                        for(int j=am_rptr[g]; j<am_rptr[g+1]; j++) {
+                            if(loc[am_cind[j]] != -1) continue;
+                            if(n == cap) {
+                                cap *= 2;
+                                idx[k] = utils::SafeRealloc<int>(idx[k], cap);
+                            }
+                            idx[k][n] = am_cind[j];
+                            loc[am_cind[j]] = n;
+                            n++;
+                        }
+                    }
+                    start = end;
+                }
+                num_loc[k] = n;
+                // Local matrix
+                int nnz = 0;
+                for(int i=0; i<n; i++) {
+                    for(int j=rptr[idx[k][i]]; j<rptr[idx[k][i]+1]; j++) {
+                        if(loc[cind[j]] != -1) nnz++;
+                    }
+                }
+                T *tval = utils::SafeMalloc<T>(nnz);
+                int *tcind = utils::SafeMalloc<int>(nnz);
+                int *trptr = utils::SafeMalloc<int>(n+1);
+                trptr[0] = 0;
+                nnz = 0;
+                for(int i=0; i<n; i++) {
+                    for(int j=rptr[idx[k][i]]; j<rptr[idx[k][i]+1]; j++) {
+                        if(loc[cind[j]] == -1) continue;
+                        tval[nnz] = val[j];
+                        tcind[nnz] = loc[cind[j]];
+                        nnz++;
+                    }
+                    trptr[i+1] = nnz;
+                    helper::QuickSort<int, T>(tcind, tval, trptr[i], trptr[i+1]-1);
+                }
+                for(int i=0; i<n; i++) { loc[idx[k][i]] = -1; }
+                // Local ILU(p)
+                T *fval = tval;
+                int *fcind = tcind;
+                int *frptr = trptr;
+                matrix::Ilup<T>(&fval, &fcind, &frptr, n, p);
+                matrix::Split<T>(fval, fcind, frptr, &lval[k], &lcind[k], &lrptr[k], &uval[k], &ucind[k], &urptr[k], nullptr, n, "L-DU", true);
+                free(tval); free(tcind); free(trptr);
+                free(fval); free(fcind); free(frptr);
+                work[k] = new T[2*n];
+            }
+            free(loc);
+        }
+        free(part);
+        free(am_cind);
+        free(am_rptr);
+        free(ptr);
+        free(own);
+    }
+    /**
+     * @brief Destructor.
+     * @details Free all memories.
+     */
+    ~Ras() {
+        for(int k=0; k<num_part; k++) {
+            free(idx[k]);
+            free(lval[k]); free(lcind[k]); free(lrptr[k]);
+            free(uval[k]); free(ucind[k]); free(urptr[k]);
+            delete[] work[k];
+        }
+        free(num_own);
+        free(num_loc);
+        free(idx);
+        free(lval); free(lcind); free(lrptr);
+        free(uval); free(ucind); free(urptr);
+        free(work);
+    }
+    /**
+     * @brief Apply the preconditioner, z = M^-1 r.
+     * @details This function must be called by all threads of an enclosing
+     * parallel region. The subdomains are distributed over the threads.
+     * @param r A 1D-array of size N.
+     * @param z A 1D-array of size N. It must not overlap r.
+     */
+    void Apply(T *r, T *z) {
+        #pragma omp for schedule(dynamic)
+        for(int k=0; k<num_part; k++) {
+            int n = num_loc[k];
+            T *xk = work[k];
+            T *yk = &work[k][n];
+            for(int i=0; i<n; i++) { xk[i] = r[idx[k][i]]; }
+            sparse::SptrsvCsr_l<T>(lval[k], lcind[k], lrptr[k], xk, yk, n);
+            sparse::SptrsvCsr_u<T>(uval[k], ucind[k], urptr[k], yk, yk, n);
+            for(int i=0; i<num_own[k]; i++) { z[idx[k][i]] = yk[i]; }
+        }
+    }
+    /**
+     * @brief Return the number of subdomains.
+     */
+    inline int GetNumPart() { return num_part; }
+    /**
+     * @brief Return the number of nodes of the extended subdomain k.
+     */
+    inline int GetSize(int k) { return num_loc[k]; }
+};
+
+} // namespace schwarz
+
+namespace solver {
+/**
+ * @brief The restricted additive Schwarz preconditioned GMRES(m) solver.
+ * @tparam T The type of a coefficient matrix and vectors.
+ * @tparam TV The type used to store the Krylov basis (e.g. float). The other vectors and all the arithmetic stay in T.
+ * @param val val array of the CSR storage format.
+ * @param cind column index array of the CSR storage format.
+ * @param rptr row pointer array of the CSR storage format.
+ * @param ras The subdomain factors built from the same matrix.
+ * @param b A right-hand side vector.
+ * @param x An unknown vector.
+ * @param nrm_b The 2-norm of b.
+ * @param outer The maximum number of iterations of outer loop.
+ * @param m The number of the restart period.
+ * @param N The size of the matrix and the vectors.
+ * @param epsilon The convergence criterion.
+ */
+template <typename T, typename TV = T>
+void RasGmresm(
+    T *val, int *cind, int *rptr,
+    schwarz::Ras<T> *ras,
+    T *b, T *x, T nrm_b,
+    int outer, int m, int N, T epsilon)
+{
+    TV *V  = new TV[N*(m+1)];
+    T *W   = new T[2*N];
+    T *t   = new T[N];
+    T *red = new T[helper::MaxThreads()];
+
+    #pragma omp parallel
+    {
+        T *c = new T[m];
+        T *s = new T[m];
+        T *e = new T[m+1];
+        T *H = new T[(m+1)*m];
+        T *y = new T[m];
+
+        int flag = 0;
+        for(int i=0; i<outer; i++) {
+            sparse::orphan::SpmvCsr<T>(val, cind, rptr, x, W, N);
+            blas1::orphan::Axpby<T>(1, b, -1, W, N);
+            e[0] = blas1::orphan::Nrm2<T>(W, red, N);
+            blas1::orphan::ScalCopy<T>(1/e[0], W, &V[0], N);
+            int j;
+            for(j=0; j<m; j++) {
+                T *w = &W[(j%2)*N];
+                T *z = &W[((j+1)%2)*N];
+                ras->Apply(w, t);
+                sparse::orphan::SpmvCsr<T>(val, cind, rptr, t, z, N);
+                for(int k=0; k<=j; k++) {
+                    H[j*(m+1)+k] = blas1::orphan::Dot<T>(&V[k*N], z, red, N);
+                    blas1::orphan::Axpy<T>(-H[j*(m+1)+k], &V[k*N], z, N);
+                }
+                H[j*(m+1)+j+1] = blas1::orphan::Nrm2<T>(z, red, N);
+                blas1::orphan::ScalCopy<T>(1/H[j*(m+1)+j+1], z, &V[(j+1)*N], N);
+                for(int k=0; k<j; k++) {
+                    blas1::Grot<T>(c[k], s[k], &H[j*(m+1)+k], &H[j*(m+1)+k+1]);
+                }
+                H[j*(m+1)+j] = blas1::Ggen<T>(H[j*(m+1)+j], H[j*(m+1)+j+1], &c[j], &s[j]);
+                H[j*(m+1)+j+1] = 0;
+                e[j+1] = s[j] * e[j];
+                e[j] = c[j] * e[j];
+#if PRINT_RES
+                #pragma omp master
+                printf("# e[%d] = %e\n", j+1, std::abs(e[j+1]/nrm_b));
+#endif
+                if(std::abs(e[j+1]) <= nrm_b*epsilon) {
+                    #pragma omp master
+                    {
+                        printf("%s iter %d\n", ITER_SYMBOL, i*m+j+1);
+                        printf("%s res %e\n", RES_SYMBOL, std::abs(e[j+1])/nrm_b);
+                    }
+                    j++;
+                    flag = 1;
+                    break;
+                }
+            }
+            blas2::Trsv<T>(H, e, y, m+1, j);
+            blas2::orphan::Gemv<T>(V, y, 0, W, j, N);
+            ras->Apply(W, t);
+            blas1::orphan::Axpy<T>(1, t, x, N);
+
+            if(flag == 1) break;
+        }
+        if(!flag) {
+            #pragma omp master
+            {
+                printf("# iter %d\n", outer*m);
+                printf("# res : Check by using senk::test\n");
+            }
+        }
+        delete[] c;
+        delete[] s;
+        delete[] e;
+        delete[] H;
+        delete[] y;
+    }
+    delete[] V;
+    delete[] W;
+    delete[] t;
+    delete[] red;
+}
+
+} // namespace solver
+
+} // namespace senk
+
+#endif
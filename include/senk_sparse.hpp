@@ -73,13 +73,28 @@ void SpmvBcsr(T *bval, int *bcind, int *brptr, T *x, T *y, int N) {
     #pragma omp parallel for
     for(int i=0; i<N; i+=bnl) {
         int bidx = i / bnl;
+        if(i+bnl > N) {
+            // The last block row has fewer than bnl rows.
+            for(int j=0; j<N-i; j++) { y[i+j] = 0; }
+            for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+                int x_ind = bcind[j]*bnw;
+                int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                for(int l=0; l<wl; l++) {
+                    for(int k=0; k<N-i; k++) {
+                        y[i+k] += bval[j*b_size+l*bnl+k] * x[x_ind+l];
+                    }
+                }
+            }
+            continue;
+        }
         #pragma omp simd simdlen(bnl)
         for(int j=0; j<bnl; j++) {
             y[i+j] = 0;
         }
         for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
             int x_ind = bcind[j]*bnw;
-            for(int l=0; l<bnw; l++) {
+            int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+            for(int l=0; l<wl; l++) {
                 int off = j*b_size+l*bnl;
                 #pragma omp simd simdlen(bnl)
                 for(int k=0; k<bnl; k++) {
@@ -107,12 +122,12 @@ void SpmvSell(T *val, int *cind, int *wid, int len, T *x, T *y, int N)
     #pragma omp parallel for
     for(int i=0; i<block; i++) {
         int start = wid[i] * len;
-        int temp = (i==len-1 && N%len!=0) ? N % len : len;
+        int temp = (i==block-1 && N%len!=0) ? N % len : len;
         for(int k=0; k<temp; k++) {
             y[i*len+k] = val[start+k] * x[cind[start+k]];
         }
         for(int j=1; j<wid[i+1]-wid[i]; j++) {
-            int off = start+j*len;
+            int off = start+j*temp;
             for(int k=0; k<temp; k++) {
                 y[i*len+k] += val[off+k] * x[cind[off+k]];
             }
@@ -261,7 +276,8 @@ void SptrsvCsr_l(
             #pragma omp for
             for(int i=start; i<end; i++) {
                 int base = i*bsize;
-                for(int l=0; l<bsize; l++) {
+                int len = (N-base < bsize) ? N-base : bsize;
+                for(int l=0; l<len; l++) {
                     int idx = base+l;
                     T temp = x[idx];
                     for(int j=rptr[idx]; j<rptr[idx+1]; j++) {
@@ -300,7 +316,8 @@ void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y,
             #pragma omp for
             for(int i=end-1; i>=start; i--) {
                 int base = i*bsize;
-                for(int l=bsize-1; l>=0; l--) {
+                int len = (N-base < bsize) ? N-base : bsize;
+                for(int l=len-1; l>=0; l--) {
                     int idx = base+l;
                     T temp = x[idx];
                     int j;
@@ -330,11 +347,10 @@ void SptrsvCsr_l(T *val, int *cind, int *rptr, T *x, T *y,
     int N, int bnum)
 {
     // L is assumed to be unit lower triangular.
-    int bsize = N / bnum;
     #pragma omp parallel for num_threads(bnum)
     for(int k=0; k<bnum; k++) {
-        int start = k*bsize;
-        int end = (k+1)*bsize;
+        int start = (int)((long)k*N/bnum);
+        int end = (int)((long)(k+1)*N/bnum);
         for(int i=start; i<end; i++) {
             T temp = x[i];
             for(int j=rptr[i]; j<rptr[i+1]; j++) {
@@ -362,11 +378,10 @@ void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y,
 {
     // U is assumed to be general upper triangular.
     // Diagonal has been inverted.
-    int bsize = N / bnum;
     #pragma omp parallel for num_threads(bnum)
     for(int k=0; k<bnum; k++) {
-        int start = k*bsize;
-        int end = (k+1)*bsize;
+        int start = (int)((long)k*N/bnum);
+        int end = (int)((long)(k+1)*N/bnum);
         for(int i=end-1; i>=start; i--) {
             T temp = x[i];
             int j;
@@ -377,6 +392,90 @@ void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y,
         }
     }
 }
+/**
+ * @brief Perform the lower triangular solve for the last block row of a BCSR matrix when it has fewer than bnl rows.
+ * @details Csr2Bcsr pads the block row with zero rows, which are skipped
+ * here, as are the columns of the last block column beyond N.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param idx The first row of the block row.
+ * @param len The number of rows of the block row.
+ * @param N The size of vectors.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsrTail_l(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int idx, int len, int N)
+{
+    int b_size = bnl * bnw;
+    int bidx = idx / bnl;
+    for(int j=0; j<len; j++) { y[idx+j] = x[idx+j]; }
+    for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+        int x_ind = bcind[j]*bnw;
+        int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+        for(int m=0; m<wl; m++) {
+            int off = j*b_size+m*bnl;
+            for(int n=0; n<len; n++) {
+                y[idx+n] -= bval[off+n] * y[x_ind+m];
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the upper triangular solve for the last block row of a BCSR matrix when it has fewer than bnl rows.
+ * @details The diagonal part of the block row consists of ceil(len/bnw)
+ * blocks, whose diagonal has been inverted.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param idx The first row of the block row.
+ * @param len The number of rows of the block row.
+ * @param N The size of vectors.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsrTail_u(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int idx, int len, int N)
+{
+    int b_size = bnl * bnw;
+    int b_rem = (len+bnw-1) / bnw;
+    int bidx = idx / bnl;
+    for(int j=0; j<len; j++) { y[idx+j] = x[idx+j]; }
+    for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+b_rem; j--) {
+        int x_ind = bcind[j]*bnw;
+        int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+        for(int m=0; m<wl; m++) {
+            int off = j*b_size+m*bnl;
+            for(int n=0; n<len; n++) {
+                y[idx+n] -= bval[off+n] * y[x_ind+m];
+            }
+        }
+    }
+    int pos = brptr[bidx]+b_rem-1;
+    for(int m=b_rem-1; m>=0; m--) {
+        for(int j=bnw-1; j>=0; j--) {
+            int ind = m*bnw+j;
+            if(ind >= len) continue;
+            int off = pos*b_size+j*bnl;
+            y[idx+ind] *= bval[off+ind];
+            for(int n=ind-1; n>=0; n--) {
+                y[idx+n] -= bval[off+n] * y[idx+ind];
+            }
+        }
+        pos--;
+    }
+}
 /**
  * @brief Perform the sparse lower triangular solve for a matrix stored in the BCSR format.
  * @tparam T The Type of the matrix and the vectors.
@@ -398,13 +497,18 @@ void SptrsvBcsr_l(
     int b_size = bnl * bnw;
     for(int i=0; i<N; i+=bnl) {
         int bidx = i / bnl;
+        if(i+bnl > N) {
+            SptrsvBcsrTail_l<T, bnl, bnw>(bval, bcind, brptr, x, y, i, N-i, N);
+            continue;
+        }
         #pragma omp simd simdlen(bnl)
         for(int j=0; j<bnl; j++) {
             y[i+j] = x[i+j];
         }
         for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
             int x_ind = bcind[j]*bnw;
-            for(int l=0; l<bnw; l++) {
+            int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+            for(int l=0; l<wl; l++) {
                 int off = j*b_size+l*bnl;
                 #pragma omp simd simdlen(bnl)
                 for(int k=0; k<bnl; k++) {
@@ -433,15 +537,20 @@ void SptrsvBcsr_u(
 {
     int b_size = bnl * bnw;
     int b_rem = bnl / bnw;
-    for(int i=N-bnl; i>=0; i-=bnl) {
+    for(int i=(N-1)/bnl*bnl; i>=0; i-=bnl) {
         int bidx = i / bnl;
+        if(i+bnl > N) {
+            SptrsvBcsrTail_u<T, bnl, bnw>(bval, bcind, brptr, x, y, i, N-i, N);
+            continue;
+        }
         #pragma omp simd simdlen(bnl)
         for(int j=0; j<bnl; j++) {
             y[i+j] = x[i+j];
         }
         for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+b_rem; j--) {
             int x_ind = bcind[j]*bnw;
-            for(int l=0; l<bnw; l++) {
+            int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+            for(int l=0; l<wl; l++) {
                 int off = j*b_size+l*bnl;
                 #pragma omp simd simdlen(bnl)
                 for(int k=0; k<bnl; k++) {
@@ -463,6 +572,69 @@ void SptrsvBcsr_u(
         }
     }
 }
+/**
+ * @brief Perform the block upper triangular solve for a block ILU factor stored in the BCSR format.
+ * @details The first block of each block row is the inverse of the diagonal
+ * block, as given by matrix::Bilup.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bs The number of rows/columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N. y may be x.
+ * @param N The size of vectors.
+ */
+template <typename T, int bs> inline
+void SptrsvBcsr_bu(
+    T *bval, int *bcind, int *brptr,
+    T *x, T *y, int N)
+{
+    int b_size = bs * bs;
+    T temp[bs];
+    for(int i=(N-1)/bs*bs; i>=0; i-=bs) {
+        int bidx = i / bs;
+        if(i+bs > N) {
+            // The last block row has fewer than bs rows. The rest of its
+            // diagonal block is the identity (see matrix::Bilup).
+            int len = N-i;
+            for(int j=0; j<bs; j++) { temp[j] = (j < len) ? x[i+j] : 0; }
+            for(int j=0; j<len; j++) {
+                T sum = 0;
+                for(int l=0; l<len; l++) { sum += bval[brptr[bidx]*b_size+l*bs+j] * temp[l]; }
+                y[i+j] = sum;
+            }
+            continue;
+        }
+        #pragma omp simd simdlen(bs)
+        for(int j=0; j<bs; j++) {
+            temp[j] = x[i+j];
+        }
+        for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+1; j--) {
+            int x_ind = bcind[j]*bs;
+            int wl = (N-x_ind < bs) ? N-x_ind : bs;
+            for(int l=0; l<wl; l++) {
+                int off = j*b_size+l*bs;
+                #pragma omp simd simdlen(bs)
+                for(int k=0; k<bs; k++) {
+                    temp[k] -= bval[off+k] * y[x_ind+l];
+                }
+            }
+        }
+        int dpos = brptr[bidx]*b_size;
+        #pragma omp simd simdlen(bs)
+        for(int k=0; k<bs; k++) {
+            y[i+k] = bval[dpos+k] * temp[0];
+        }
+        for(int l=1; l<bs; l++) {
+            int off = dpos+l*bs;
+            #pragma omp simd simdlen(bs)
+            for(int k=0; k<bs; k++) {
+                y[i+k] += bval[off+k] * temp[l];
+            }
+        }
+    }
+}
 /**
  * @brief Perform the sparse lower triangular solve for a ABMC reordered matrix stored in the BCSR format.
  * @tparam T The Type of the matrix and the vectors.
@@ -493,16 +665,22 @@ void SptrsvBcsr_l(
             #pragma omp for
             for(int i=start; i<end; i++) {
                 int base = i*bsize;
-                for(int l=0; l<bsize; l+=bnl) {
+                int len = (N-base < bsize) ? N-base : bsize;
+                for(int l=0; l<len; l+=bnl) {
                     int idx = base+l;
                     int bidx = idx / bnl;
+                    if(idx+bnl > N) {
+                        SptrsvBcsrTail_l<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                        continue;
+                    }
                     #pragma omp simd simdlen(bnl)
                     for(int j=0; j<bnl; j++) {
                         y[idx+j] = x[idx+j];
                     }
                     for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
                         int x_ind = bcind[j]*bnw;
-                        for(int m=0; m<bnw; m++) {
+                        int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                        for(int m=0; m<wl; m++) {
                             int off = j*b_size+m*bnl;
                             #pragma omp simd simdlen(bnl)
                             for(int n=0; n<bnl; n++) {
@@ -545,16 +723,148 @@ void SptrsvBcsr_u(
             #pragma omp for
             for(int i=end-1; i>=start; i--) {
                 int base = i*bsize;
-                for(int l=bsize-bnl; l>=0; l-=bnl) {
+                int len = (N-base < bsize) ? N-base : bsize;
+                for(int l=(len-1)/bnl*bnl; l>=0; l-=bnl) {
                     int idx = base+l;
                     int bidx = idx / bnl;
+                    if(idx+bnl > N) {
+                        SptrsvBcsrTail_u<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                        continue;
+                    }
+                    #pragma omp simd simdlen(bnl)
+                    for(int j=0; j<bnl; j++) {
+                        y[idx+j] = x[idx+j];
+                    }
+                    for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+b_rem; j--) {
+                        int x_ind = bcind[j]*bnw;
+                        int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                        for(int n=0; n<wl; n++) {
+                            int off = j*b_size+n*bnl;
+                            #pragma omp simd simdlen(bnl)
+                            for(int m=0; m<bnl; m++) {
+                                y[idx+m] -= bval[off+m] * y[x_ind+n];
+                            }
+                        }
+                    }
+                    int pos = brptr[bidx]+b_rem-1;
+                    for(int m=b_rem-1; m>=0; m--) {
+                        for(int j=bnw-1; j>=0; j--) {
+                            int off = pos*b_size+j*bnl;
+                            int ind = m*bnw+j;
+                            y[idx+ind] *= bval[off+ind];
+                            for(int n=m*bnw+j-1; n>=0; n--) {
+                                y[idx+n] -= bval[off+n] * y[idx+ind];
+                            }
+                        }
+                        pos--;
+                    }
+                }
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the sparse lower triangular solve for a hierarchical ABMC reordered matrix stored in the BCSR format.
+ * @details The super-blocks of a color are distributed over the threads and
+ * each super-block is solved block row by block row (see graph::GetHABMCPermutation).
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting super-block of each color is stored.
+ * @param cnum The number of colors.
+ * @param sptr The starting row of each super-block is stored. Each super-block except the last is a multiple of bnl rows.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_l(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int N, int *cptr, int cnum, int *sptr)
+{
+    // L is assumed to be unit lower triangular.
+    int b_size = bnl * bnw;
+    #pragma omp parallel
+    {
+        for(int k=0; k<cnum; k++) {
+            int start = cptr[k];
+            int end = cptr[k+1];
+            #pragma omp for
+            for(int i=start; i<end; i++) {
+                for(int idx=sptr[i]; idx<sptr[i+1]; idx+=bnl) {
+                    int bidx = idx / bnl;
+                    if(idx+bnl > N) {
+                        SptrsvBcsrTail_l<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                        continue;
+                    }
+                    #pragma omp simd simdlen(bnl)
+                    for(int j=0; j<bnl; j++) {
+                        y[idx+j] = x[idx+j];
+                    }
+                    for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+                        int x_ind = bcind[j]*bnw;
+                        int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                        for(int m=0; m<wl; m++) {
+                            int off = j*b_size+m*bnl;
+                            #pragma omp simd simdlen(bnl)
+                            for(int n=0; n<bnl; n++) {
+                                y[idx+n] -= bval[off+n] * y[x_ind+m];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the sparse upper triangular solve for a hierarchical ABMC reordered matrix stored in the BCSR format.
+ * @details The super-blocks of a color are distributed over the threads and
+ * each super-block is solved block row by block row backward (see graph::GetHABMCPermutation).
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting super-block of each color is stored.
+ * @param cnum The number of colors.
+ * @param sptr The starting row of each super-block is stored. Each super-block except the last is a multiple of bnl rows.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_u(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int N, int *cptr, int cnum, int *sptr)
+{
+    int b_size = bnl * bnw;
+    int b_rem = bnl / bnw;
+    #pragma omp parallel
+    {
+        for(int k=cnum-1; k>=0; k--) {
+            int start = cptr[k];
+            int end = cptr[k+1];
+            #pragma omp for
+            for(int i=end-1; i>=start; i--) {
+                for(int idx=sptr[i]+(sptr[i+1]-sptr[i]-1)/bnl*bnl; idx>=sptr[i]; idx-=bnl) {
+                    int bidx = idx / bnl;
+                    if(idx+bnl > N) {
+                        SptrsvBcsrTail_u<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                        continue;
+                    }
                     #pragma omp simd simdlen(bnl)
                     for(int j=0; j<bnl; j++) {
                         y[idx+j] = x[idx+j];
                     }
                     for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+b_rem; j--) {
                         int x_ind = bcind[j]*bnw;
-                        for(int n=0; n<bnw; n++) {
+                        int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                        for(int n=0; n<wl; n++) {
                             int off = j*b_size+n*bnl;
                             #pragma omp simd simdlen(bnl)
                             for(int m=0; m<bnl; m++) {
@@ -579,6 +889,808 @@ void SptrsvBcsr_u(
         }
     }
 }
+/**
+ * @brief Orphaned versions of the SpMV and SpTRSV functions.
+ * @details These functions must be called by all threads of an enclosing
+ * parallel region and end with a barrier. The sequential triangular solves
+ * are performed by a single thread of the team.
+ */
+namespace orphan {
+/**
+ * @brief Perform SpMV using the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void SpmvCsr(T *val, int *cind, int *rptr, T *x, T *y, int N) {
+    #pragma omp for
+    for(int i=0; i<N; i++) {
+        T temp = 0;
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            temp += val[j] * x[cind[j]];
+        }
+        y[i] = temp;
+    }
+}
+/**
+ * @brief Perform SpMV using the CSR format, which stores diagonal elements separately.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param diag An array that stores diagonal elements.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void SpmvCsr(T *val, int *cind, int *rptr, T *diag, T *x, T *y, int N) {
+    #pragma omp for
+    for(int i=0; i<N; i++) {
+        T temp = x[i] * diag[i];
+        for(int j=rptr[i]; j<rptr[i+1]; j++) {
+            temp += val[j] * x[cind[j]];
+        }
+        y[i] = temp;
+    }
+}
+/**
+ * @brief Perform SpMV using the BCSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A col-index array in the BCSR format.
+ * @param brptr A row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T, int bnl, int bnw> inline
+void SpmvBcsr(T *bval, int *bcind, int *brptr, T *x, T *y, int N) {
+    int b_size = bnl * bnw;
+    #pragma omp for
+    for(int i=0; i<N; i+=bnl) {
+        int bidx = i / bnl;
+        if(i+bnl > N) {
+            // The last block row has fewer than bnl rows.
+            for(int j=0; j<N-i; j++) { y[i+j] = 0; }
+            for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+                int x_ind = bcind[j]*bnw;
+                int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                for(int l=0; l<wl; l++) {
+                    for(int k=0; k<N-i; k++) {
+                        y[i+k] += bval[j*b_size+l*bnl+k] * x[x_ind+l];
+                    }
+                }
+            }
+            continue;
+        }
+        #pragma omp simd simdlen(bnl)
+        for(int j=0; j<bnl; j++) {
+            y[i+j] = 0;
+        }
+        for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+            int x_ind = bcind[j]*bnw;
+            int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+            for(int l=0; l<wl; l++) {
+                int off = j*b_size+l*bnl;
+                #pragma omp simd simdlen(bnl)
+                for(int k=0; k<bnl; k++) {
+                    y[i+k] += bval[off+k] * x[x_ind+l];
+                }
+            }
+        }
+    }
+}
+/**
+ * @brief Perform SpMV using the sliced-ELLPACK (SELL-c) format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the SELL-c format.
+ * @param cind A col-index array in the SELL-c format.
+ * @param wid An array that indicates the starting position of the slices.
+ * @param len The size of the slices.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void SpmvSell(T *val, int *cind, int *wid, int len, T *x, T *y, int N)
+{
+    int block = (N+len-1)/len;
+    #pragma omp for
+    for(int i=0; i<block; i++) {
+        int start = wid[i] * len;
+        int temp = (i==block-1 && N%len!=0) ? N % len : len;
+        for(int k=0; k<temp; k++) {
+            y[i*len+k] = val[start+k] * x[cind[start+k]];
+        }
+        for(int j=1; j<wid[i+1]-wid[i]; j++) {
+            int off = start+j*temp;
+            for(int k=0; k<temp; k++) {
+                y[i*len+k] += val[off+k] * x[cind[off+k]];
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the sparse lower triangular solve on a matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void SptrsvCsr_l(T *val, int *cind, int *rptr, T *x, T *y, int N)
+{
+    #pragma omp single
+    sparse::SptrsvCsr_l<T>(val, cind, rptr, x, y, N);
+}
+/**
+ * @brief Perform the sparse upper triangular solve on a matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y, int N)
+{
+    #pragma omp single
+    sparse::SptrsvCsr_u<T>(val, cind, rptr, x, y, N);
+}
+/**
+ * @brief Perform the sparse lower triangular solve in parallel on a AMC ordered matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ */
+template <typename T> inline
+void SptrsvCsr_l(
+    T *val, int *cind, int *rptr, T *x, T *y,
+    int N, int *cptr, int cnum)
+{
+    // L is assumed to be unit lower triangular.
+    for(int k=0; k<cnum; k++) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=start; i<end; i++) {
+            T temp = x[i];
+            for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                temp -= val[j] * y[cind[j]];
+            }
+            y[i] = temp;
+        }
+    } 
+}
+/**
+ * @brief Perform the sparse upper triangular solve in parallel on a AMC ordered matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ */
+template <typename T> inline
+void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y,
+    int N, int *cptr, int cnum)
+{
+    // U is assumed to be general upper triangular.
+    // Diagonal has been inverted.
+    for(int k=cnum-1; k>=0; k--) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=end-1; i>=start; i--) {
+            T temp = x[i];
+            int j;
+            for(j=rptr[i+1]-1; j>=rptr[i]+1; j--) {
+                temp -= val[j] * y[cind[j]];    
+            }
+            y[i] = temp * val[j];
+        }
+    }
+}
+/**
+ * @brief Perform the sparse lower triangular solve in parallel on a ABMC ordered matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ * @param bsize The number of rows/columns of the blocks used in ABMC.
+ */
+template <typename T> inline
+void SptrsvCsr_l(
+    T *val, int *cind, int *rptr, T *x, T *y,
+    int N, int *cptr, int cnum, int bsize)
+{
+    // L is assumed to be unit lower triangular.
+    for(int k=0; k<cnum; k++) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=start; i<end; i++) {
+            int base = i*bsize;
+            int len = (N-base < bsize) ? N-base : bsize;
+            for(int l=0; l<len; l++) {
+                int idx = base+l;
+                T temp = x[idx];
+                for(int j=rptr[idx]; j<rptr[idx+1]; j++) {
+                    temp -= val[j] * y[cind[j]];
+                }
+                y[idx] = temp;
+            }
+        }
+    } 
+}
+/**
+ * @brief Perform the sparse upper triangular solve in parallel on a ABMC ordered matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ * @param bsize The number of rows/columns of the blocks used in ABMC.
+ */
+template <typename T> inline
+void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y,
+    int N, int *cptr, int cnum, int bsize)
+{
+    // U is assumed to be general upper triangular.
+    // Diagonal has been inverted.
+    for(int k=cnum-1; k>=0; k--) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=end-1; i>=start; i--) {
+            int base = i*bsize;
+            int len = (N-base < bsize) ? N-base : bsize;
+            for(int l=len-1; l>=0; l--) {
+                int idx = base+l;
+                T temp = x[idx];
+                int j;
+                for(j=rptr[idx+1]-1; j>=rptr[idx]+1; j--) {
+                    temp -= val[j] * y[cind[j]];    
+                }
+                y[idx] = temp * val[j];
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the block Jacobi sparse lower triangular solve on a matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param bptr The starting index of each block is stored.
+ * @param bnum The number of the blocks.
+ */
+template <typename T> inline
+void SptrsvCsr_l(T *val, int *cind, int *rptr, T *x, T *y,
+    int N, int bnum)
+{
+    // L is assumed to be unit lower triangular.
+    #pragma omp for
+    for(int k=0; k<bnum; k++) {
+        int start = (int)((long)k*N/bnum);
+        int end = (int)((long)(k+1)*N/bnum);
+        for(int i=start; i<end; i++) {
+            T temp = x[i];
+            for(int j=rptr[i]; j<rptr[i+1]; j++) {
+                temp -= val[j] * y[cind[j]];
+            }
+            y[i] = temp;
+        }
+    }
+}
+/**
+ * @brief Perform the block Jacobi sparse upper triangular solve on a matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param bptr The starting index of each block is stored.
+ * @param bnum The number of the blocks.
+ */
+template <typename T> inline
+void SptrsvCsr_u(T *val, int *cind, int *rptr, T *x, T *y,
+    int N, int bnum)
+{
+    // U is assumed to be general upper triangular.
+    // Diagonal has been inverted.
+    #pragma omp for
+    for(int k=0; k<bnum; k++) {
+        int start = (int)((long)k*N/bnum);
+        int end = (int)((long)(k+1)*N/bnum);
+        for(int i=end-1; i>=start; i--) {
+            T temp = x[i];
+            int j;
+            for(j=rptr[i+1]-1; j>=rptr[i]+1; j--) {
+                temp -= val[j] * y[cind[j]];    
+            }
+            y[i] = temp * val[j];
+        }
+    }
+}
+/**
+ * @brief Perform the sparse lower triangular solve for a matrix stored in the BCSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_l(
+    T *bval, int *bcind, int *brptr, 
+    T *x, T *y, int N)
+{
+    #pragma omp single
+    sparse::SptrsvBcsr_l<T, bnl, bnw>(bval, bcind, brptr, x, y, N);
+}
+/**
+ * @brief Perform the sparse upper triangular solve for a matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_u(
+    T *bval, int *bcind, int *brptr,
+    T *x, T *y, int N)
+{
+    #pragma omp single
+    sparse::SptrsvBcsr_u<T, bnl, bnw>(bval, bcind, brptr, x, y, N);
+}
+/**
+ * @brief Perform the block upper triangular solve for a block ILU factor stored in the BCSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bs The number of rows/columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N. y may be x.
+ * @param N The size of vectors.
+ */
+template <typename T, int bs> inline
+void SptrsvBcsr_bu(
+    T *bval, int *bcind, int *brptr,
+    T *x, T *y, int N)
+{
+    #pragma omp single
+    sparse::SptrsvBcsr_bu<T, bs>(bval, bcind, brptr, x, y, N);
+}
+/**
+ * @brief Perform the sparse lower triangular solve for a ABMC reordered matrix stored in the BCSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ * @param bsize The number of rows/columns of the blocks used in ABMC.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_l(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int N, int *cptr, int cnum, int bsize)
+{
+    // L is assumed to be unit lower triangular.
+    int b_size = bnl * bnw;
+    for(int k=0; k<cnum; k++) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=start; i<end; i++) {
+            int base = i*bsize;
+            int len = (N-base < bsize) ? N-base : bsize;
+            for(int l=0; l<len; l+=bnl) {
+                int idx = base+l;
+                int bidx = idx / bnl;
+                if(idx+bnl > N) {
+                    SptrsvBcsrTail_l<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                    continue;
+                }
+                #pragma omp simd simdlen(bnl)
+                for(int j=0; j<bnl; j++) {
+                    y[idx+j] = x[idx+j];
+                }
+                for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+                    int x_ind = bcind[j]*bnw;
+                    int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                    for(int m=0; m<wl; m++) {
+                        int off = j*b_size+m*bnl;
+                        #pragma omp simd simdlen(bnl)
+                        for(int n=0; n<bnl; n++) {
+                            y[idx+n] -= bval[off+n] * y[x_ind+m];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the sparse upper triangular solve for a ABMC reordered matrix stored in the CSR format.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting index of each color is stored.
+ * @param cnum The number of colors.
+ * @param bsize The number of rows/columns of the blocks used in ABMC.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_u(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int N, int *cptr, int cnum, int bsize)
+{
+    int b_size = bnl * bnw;
+    int b_rem = bnl / bnw;
+    for(int k=cnum-1; k>=0; k--) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=end-1; i>=start; i--) {
+            int base = i*bsize;
+            int len = (N-base < bsize) ? N-base : bsize;
+            for(int l=(len-1)/bnl*bnl; l>=0; l-=bnl) {
+                int idx = base+l;
+                int bidx = idx / bnl;
+                if(idx+bnl > N) {
+                    SptrsvBcsrTail_u<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                    continue;
+                }
+                #pragma omp simd simdlen(bnl)
+                for(int j=0; j<bnl; j++) {
+                    y[idx+j] = x[idx+j];
+                }
+                for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+b_rem; j--) {
+                    int x_ind = bcind[j]*bnw;
+                    int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                    for(int n=0; n<wl; n++) {
+                        int off = j*b_size+n*bnl;
+                        #pragma omp simd simdlen(bnl)
+                        for(int m=0; m<bnl; m++) {
+                            y[idx+m] -= bval[off+m] * y[x_ind+n];
+                        }
+                    }
+                }
+                int pos = brptr[bidx]+b_rem-1;
+                for(int m=b_rem-1; m>=0; m--) {
+                    for(int j=bnw-1; j>=0; j--) {
+                        int off = pos*b_size+j*bnl;
+                        int ind = m*bnw+j;
+                        y[idx+ind] *= bval[off+ind];
+                        for(int n=m*bnw+j-1; n>=0; n--) {
+                            y[idx+n] -= bval[off+n] * y[idx+ind];
+                        }
+                    }
+                    pos--;
+                }
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the sparse lower triangular solve for a hierarchical ABMC reordered matrix stored in the BCSR format.
+ * @details The super-blocks of a color are distributed over the threads and
+ * each super-block is solved block row by block row (see graph::GetHABMCPermutation).
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting super-block of each color is stored.
+ * @param cnum The number of colors.
+ * @param sptr The starting row of each super-block is stored. Each super-block except the last is a multiple of bnl rows.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_l(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int N, int *cptr, int cnum, int *sptr)
+{
+    // L is assumed to be unit lower triangular.
+    int b_size = bnl * bnw;
+    for(int k=0; k<cnum; k++) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=start; i<end; i++) {
+            for(int idx=sptr[i]; idx<sptr[i+1]; idx+=bnl) {
+                int bidx = idx / bnl;
+                if(idx+bnl > N) {
+                    SptrsvBcsrTail_l<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                    continue;
+                }
+                #pragma omp simd simdlen(bnl)
+                for(int j=0; j<bnl; j++) {
+                    y[idx+j] = x[idx+j];
+                }
+                for(int j=brptr[bidx]; j<brptr[bidx+1]; j++) {
+                    int x_ind = bcind[j]*bnw;
+                    int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                    for(int m=0; m<wl; m++) {
+                        int off = j*b_size+m*bnl;
+                        #pragma omp simd simdlen(bnl)
+                        for(int n=0; n<bnl; n++) {
+                            y[idx+n] -= bval[off+n] * y[x_ind+m];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+/**
+ * @brief Perform the sparse upper triangular solve for a hierarchical ABMC reordered matrix stored in the BCSR format.
+ * @details The super-blocks of a color are distributed over the threads and
+ * each super-block is solved block row by block row backward (see graph::GetHABMCPermutation).
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A block col-index array in the BCSR format.
+ * @param brptr A block row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param N The size of vectors.
+ * @param cptr The starting super-block of each color is stored.
+ * @param cnum The number of colors.
+ * @param sptr The starting row of each super-block is stored. Each super-block except the last is a multiple of bnl rows.
+ */
+template <typename T, int bnl, int bnw> inline
+void SptrsvBcsr_u(
+    T *bval, int *bcind, int *brptr, T *x, T *y,
+    int N, int *cptr, int cnum, int *sptr)
+{
+    int b_size = bnl * bnw;
+    int b_rem = bnl / bnw;
+    for(int k=cnum-1; k>=0; k--) {
+        int start = cptr[k];
+        int end = cptr[k+1];
+        #pragma omp for
+        for(int i=end-1; i>=start; i--) {
+            for(int idx=sptr[i]+(sptr[i+1]-sptr[i]-1)/bnl*bnl; idx>=sptr[i]; idx-=bnl) {
+                int bidx = idx / bnl;
+                if(idx+bnl > N) {
+                    SptrsvBcsrTail_u<T, bnl, bnw>(bval, bcind, brptr, x, y, idx, N-idx, N);
+                    continue;
+                }
+                #pragma omp simd simdlen(bnl)
+                for(int j=0; j<bnl; j++) {
+                    y[idx+j] = x[idx+j];
+                }
+                for(int j=brptr[bidx+1]-1; j>=brptr[bidx]+b_rem; j--) {
+                    int x_ind = bcind[j]*bnw;
+                    int wl = (N-x_ind < bnw) ? N-x_ind : bnw;
+                    for(int n=0; n<wl; n++) {
+                        int off = j*b_size+n*bnl;
+                        #pragma omp simd simdlen(bnl)
+                        for(int m=0; m<bnl; m++) {
+                            y[idx+m] -= bval[off+m] * y[x_ind+n];
+                        }
+                    }
+                }
+                int pos = brptr[bidx]+b_rem-1;
+                for(int m=b_rem-1; m>=0; m--) {
+                    for(int j=bnw-1; j>=0; j--) {
+                        int off = pos*b_size+j*bnl;
+                        int ind = m*bnw+j;
+                        y[idx+ind] *= bval[off+ind];
+                        for(int n=m*bnw+j-1; n>=0; n--) {
+                            y[idx+n] -= bval[off+n] * y[idx+ind];
+                        }
+                    }
+                    pos--;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Apply the Chebyshev polynomial preconditioner, y = p(A) x, using the CSR format.
+ * @details p(A) approximates A^-1 by deg steps of the Chebyshev iteration
+ * on the interval [lmin, lmax] started from zero. It needs deg-1 SpMVs and
+ * no reductions. x and y must not overlap.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the CSR format.
+ * @param cind A col-index array in the CSR format.
+ * @param rptr A row-pointer array in the CSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param work A work array of size 3 * N.
+ * @param lmin The lower bound of the spectrum.
+ * @param lmax The upper bound of the spectrum.
+ * @param deg The number of Chebyshev steps, i.e. the degree of p plus one.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void ChebyCsr(T *val, int *cind, int *rptr, T *x, T *y, T *work, T lmin, T lmax, int deg, int N)
+{
+    T *r  = work;
+    T *p  = &work[N];
+    T *Ap = &work[2*N];
+    T d = (lmax + lmin) / 2;
+    T c = (lmax - lmin) / 2;
+    T alpha = 1 / d;
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { y[i] = alpha * x[i]; }
+    for(int k=1; k<deg; k++) {
+        // In the first step, both the residual and the direction are x.
+        T *rk = (k == 1) ? x : r;
+        T *pk = (k == 1) ? x : p;
+        SpmvCsr<T>(val, cind, rptr, pk, Ap, N);
+        T beta = (k == 1) ? c*alpha * c*alpha / 2 : (c*alpha/2) * (c*alpha/2);
+        T alpha_new = 1 / (d - beta / alpha);
+        #pragma omp for simd
+        for(int i=0; i<N; i++) {
+            T temp = rk[i] - alpha * Ap[i];
+            r[i] = temp;
+            p[i] = temp + beta * pk[i];
+            y[i] += alpha_new * p[i];
+        }
+        alpha = alpha_new;
+    }
+}
+/**
+ * @brief Apply the Chebyshev polynomial preconditioner, y = p(A) x, using the BCSR format.
+ * @details p(A) approximates A^-1 by deg steps of the Chebyshev iteration
+ * on the interval [lmin, lmax] started from zero. It needs deg-1 SpMVs and
+ * no reductions. x and y must not overlap.
+ * @tparam T The Type of the matrix and the vectors.
+ * @tparam bnl The number of rows of the block.
+ * @tparam bnw The number of columns of the block.
+ * @param bval A val array in the BCSR format.
+ * @param bcind A col-index array in the BCSR format.
+ * @param brptr A row-pointer array in the BCSR format.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param work A work array of size 3 * N.
+ * @param lmin The lower bound of the spectrum.
+ * @param lmax The upper bound of the spectrum.
+ * @param deg The number of Chebyshev steps, i.e. the degree of p plus one.
+ * @param N The size of vectors.
+ */
+template <typename T, int bnl, int bnw> inline
+void ChebyBcsr(T *bval, int *bcind, int *brptr, T *x, T *y, T *work, T lmin, T lmax, int deg, int N)
+{
+    T *r  = work;
+    T *p  = &work[N];
+    T *Ap = &work[2*N];
+    T d = (lmax + lmin) / 2;
+    T c = (lmax - lmin) / 2;
+    T alpha = 1 / d;
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { y[i] = alpha * x[i]; }
+    for(int k=1; k<deg; k++) {
+        // In the first step, both the residual and the direction are x.
+        T *rk = (k == 1) ? x : r;
+        T *pk = (k == 1) ? x : p;
+        SpmvBcsr<T, bnl, bnw>(bval, bcind, brptr, pk, Ap, N);
+        T beta = (k == 1) ? c*alpha * c*alpha / 2 : (c*alpha/2) * (c*alpha/2);
+        T alpha_new = 1 / (d - beta / alpha);
+        #pragma omp for simd
+        for(int i=0; i<N; i++) {
+            T temp = rk[i] - alpha * Ap[i];
+            r[i] = temp;
+            p[i] = temp + beta * pk[i];
+            y[i] += alpha_new * p[i];
+        }
+        alpha = alpha_new;
+    }
+}
+/**
+ * @brief Apply the Chebyshev polynomial preconditioner, y = p(A) x, using the SELL-c format.
+ * @details p(A) approximates A^-1 by deg steps of the Chebyshev iteration
+ * on the interval [lmin, lmax] started from zero. It needs deg-1 SpMVs and
+ * no reductions. x and y must not overlap.
+ * @tparam T The Type of the matrix and the vectors.
+ * @param val A val array in the SELL-c format.
+ * @param cind A col-index array in the SELL-c format.
+ * @param wid An array that indicates the starting position of the slices.
+ * @param len The size of the slices.
+ * @param x Input vector of size N.
+ * @param y Output vector of size N.
+ * @param work A work array of size 3 * N.
+ * @param lmin The lower bound of the spectrum.
+ * @param lmax The upper bound of the spectrum.
+ * @param deg The number of Chebyshev steps, i.e. the degree of p plus one.
+ * @param N The size of vectors.
+ */
+template <typename T> inline
+void ChebySell(T *val, int *cind, int *wid, int len, T *x, T *y, T *work, T lmin, T lmax, int deg, int N)
+{
+    T *r  = work;
+    T *p  = &work[N];
+    T *Ap = &work[2*N];
+    T d = (lmax + lmin) / 2;
+    T c = (lmax - lmin) / 2;
+    T alpha = 1 / d;
+    #pragma omp for simd
+    for(int i=0; i<N; i++) { y[i] = alpha * x[i]; }
+    for(int k=1; k<deg; k++) {
+        // In the first step, both the residual and the direction are x.
+        T *rk = (k == 1) ? x : r;
+        T *pk = (k == 1) ? x : p;
+        SpmvSell<T>(val, cind, wid, len, pk, Ap, N);
+        T beta = (k == 1) ? c*alpha * c*alpha / 2 : (c*alpha/2) * (c*alpha/2);
+        T alpha_new = 1 / (d - beta / alpha);
+        #pragma omp for simd
+        for(int i=0; i<N; i++) {
+            T temp = rk[i] - alpha * Ap[i];
+            r[i] = temp;
+            p[i] = temp + beta * pk[i];
+            y[i] += alpha_new * p[i];
+        }
+        alpha = alpha_new;
+    }
+}
+} // namespace orphan
 // ---- experimental ---- //
 /*
 void SpmmCscCsc(
@@ -3,6 +3,7 @@
 
 #include "senk_blas1.hpp"
 #include "senk_sparse.hpp"
+#include "senk_blas2.hpp"
 
 namespace senk {
 
@@ -21,6 +22,42 @@ void RelativeResidualError(
     free(t);
 }
 
+void DenseResidualError(int n, int num_trial)
+{
+    // Random systems whose small diagonal forces a row swap at every step
+    double *A = (double*)malloc(sizeof(double)*n*n);
+    double *A0 = (double*)malloc(sizeof(double)*n*n);
+    double *b = (double*)malloc(sizeof(double)*n);
+    double *b0 = (double*)malloc(sizeof(double)*n);
+    double *x = (double*)malloc(sizeof(double)*n);
+    unsigned int seed = 1;
+    double max_res = 0;
+    for(int trial=0; trial<num_trial; trial++) {
+        for(int i=0; i<n*n; i++) {
+            seed = seed * 1103515245u + 12345u;
+            A[i] = (double)(seed >> 8) / (1u << 24) - 0.5;
+        }
+        for(int i=0; i<n; i++) {
+            A[i*n+i] *= 1e-3;
+            seed = seed * 1103515245u + 12345u;
+            b[i] = (double)(seed >> 8) / (1u << 24) - 0.5;
+        }
+        for(int i=0; i<n*n; i++) { A0[i] = A[i]; }
+        for(int i=0; i<n; i++) { b0[i] = b[i]; }
+        senk::blas2::Gesv<double>(A, b, x, n);
+        double nrm_r = 0, nrm_b = 0;
+        for(int i=0; i<n; i++) {
+            double r = b0[i];
+            for(int j=0; j<n; j++) { r -= A0[j*n+i] * x[j]; }
+            nrm_r += r * r;
+            nrm_b += b0[i] * b0[i];
+        }
+        if(max_res < std::sqrt(nrm_r/nrm_b)) max_res = std::sqrt(nrm_r/nrm_b);
+    }
+    printf("# test %e\n", max_res);
+    free(A); free(A0); free(b); free(b0); free(x);
+}
+
 }
 
 }
@@ -39,9 +39,9 @@ int main(int argc, char **argv)
     free(tcind);
     free(trptr);
 
-// Padding
+// Padding (optional: the blocked orderings and formats allow a smaller last block)
     int ori_N = N;
-    senk::matrix::Padding(&val, &cind, &rptr, 128, &N);
+    //senk::matrix::Padding(&val, &cind, &rptr, 128, &N);
     printf("%d\n", rptr[N]);
     M = N;
     printf("%d %d\n", N, M);
@@ -55,11 +55,7 @@ int main(int argc, char **argv)
     senk::graph::GetABMCPermutation(
         cind, rptr, &num_color, &size_color, &LP, &RP, N, 128, false, "connect");
     senk::matrix::Reordering<double>(val, cind, rptr, LP, RP, N);
-    printf("# ");
-    for(int i=0; i<num_color; i++) {
-        printf("%d ", size_color[i+1]-size_color[i]);   
-    }
-    printf("\n");
+    senk::graph::PrintOccupancy(num_color, size_color, senk::helper::MaxThreads());
     printf("# Reordered!\n");
 
 // Scaling
@@ -159,6 +155,40 @@ int main(int argc, char **argv)
     //    val, cind, rptr,
     //    blval, blcind, blrptr, buval, bucind, burptr,
     //    b, x, nrm_b, max_iter, N, epsilon);
+
+    //senk::solver::Bicgstabl<double>(
+    //    val, cind, rptr,
+    //    b, x, nrm_b, max_iter/4, 4, N, epsilon);
+    //senk::solver::IluBicgstabl<double>(
+    //    val, cind, rptr,
+    //    lval, lcind, lrptr, uval, ucind, urptr,
+    //    b, x, nrm_b, max_iter/4, 4, N, epsilon);
+    //senk::solver::AbmcIluBicgstabl<double>(
+    //    val, cind, rptr,
+    //    lval, lcind, lrptr, uval, ucind, urptr,
+    //    size_color, num_color, 128,
+    //    b, x, nrm_b, max_iter/4, 4, N, epsilon);
+    //senk::solver::IlubBicgstabl<double, bnl, bnw>(
+    //    val, cind, rptr,
+    //    blval, blcind, blrptr, buval, bucind, burptr,
+    //    b, x, nrm_b, max_iter/4, 4, N, epsilon);
+
+    //senk::solver::Idrs<double>(
+    //    val, cind, rptr,
+    //    b, x, nrm_b, max_iter, 4, N, epsilon);
+    //senk::solver::IluIdrs<double>(
+    //    val, cind, rptr,
+    //    lval, lcind, lrptr, uval, ucind, urptr,
+    //    b, x, nrm_b, max_iter, 4, N, epsilon);
+    //senk::solver::AbmcIluIdrs<double>(
+    //    val, cind, rptr,
+    //    lval, lcind, lrptr, uval, ucind, urptr,
+    //    size_color, num_color, 128,
+    //    b, x, nrm_b, max_iter, 4, N, epsilon);
+    //senk::solver::IlubIdrs<double, bnl, bnw>(
+    //    val, cind, rptr,
+    //    blval, blcind, blrptr, buval, bucind, burptr,
+    //    b, x, nrm_b, max_iter, 4, N, epsilon);
     
     //senk::solver::Gcrm<double>(
     //    val, cind, rptr,
@@ -180,6 +210,7 @@ int main(int argc, char **argv)
 
     senk::test::RelativeResidualError(
         val, cind, rptr, b, x, N);
+    senk::test::DenseResidualError(8, 100);
     
     senk::utils::SafeFree<double>(&x);
 